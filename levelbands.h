@@ -0,0 +1,13 @@
+// Generated by tools/difficulty (make bands), do not edit by hand
+//
+// Estimated difficulty order (easiest first):
+//   1 3 5 4 2 15 6 8 10 17 7 19 11 23 14 27 9 26 16 25
+//   12 18 32 34 30 29 21 33 20 13 24 37 22 28 38 39 36 35 31 40
+
+// 0 = BEGINNER, 1 = INTERMEDIATE, 2 = ADVANCED, 3 = EXPERT
+const uint8_t levelBands[] PROGMEM = {
+  0, 0, 0, 0, 0, 0, 1, 0, 1, 0,
+  1, 2, 2, 1, 0, 1, 0, 2, 1, 2,
+  2, 3, 1, 3, 1, 1, 1, 3, 2, 2,
+  3, 2, 2, 2, 3, 3, 3, 3, 3, 3,
+};
@@ -0,0 +1,106 @@
+// Generated by tools/solve -o levelhints.h, do not edit by hand
+//
+// One optimal solution per level, 2 bits per tilt with the first tilt in the low bits
+// (0 = LEFT, 1 = UP, 2 = RIGHT, 3 = DOWN). Level N starts at levelHints[levelHintOffsets[N - 1]].
+
+#define LEVEL_HINTS_MAX_LENGTH 37
+
+// The longest optimal solution in each difficulty band but the last (see TiltSolver_BandForLength)
+const uint8_t levelBandMaxLengths[] PROGMEM = { 12, 20, 28 };
+
+const uint8_t levelHintLengths[] PROGMEM = {
+  7, 9, 7, 10, 4, 12, 15, 19, 8, 12,
+  16, 13, 14, 17, 10, 20, 12, 22, 10, 28,
+  27, 7, 17, 26, 21, 21, 23, 31, 28, 25,
+  18, 15, 28, 23, 17, 23, 25, 31, 34, 37,
+};
+
+const uint16_t levelHintOffsets[] PROGMEM = {
+  0, 2, 5, 7, 10, 11, 14, 18, 23, 25,
+  28, 32, 36, 40, 45, 48, 53, 56, 62, 65,
+  72, 79, 81, 86, 93, 99, 105, 111, 119, 126,
+  133, 138, 142, 149, 155, 160, 166, 173, 181, 190,
+};
+
+const uint8_t levelHints[] PROGMEM = {
+  // LEVEL 01: DRURULD
+  0x9b, 0x31,
+  // LEVEL 02: RDLURDLUR
+  0x4e, 0x4e, 0x02,
+  // LEVEL 03: RDRUDLU
+  0x6e, 0x13,
+  // LEVEL 04: RULDURDLUR
+  0xc6, 0x39, 0x09,
+  // LEVEL 05: RULD
+  0xc6,
+  // LEVEL 06: RDLURDLURULD
+  0x4e, 0x4e, 0xc6,
+  // LEVEL 07: RULDLURDRURDLUR
+  0xc6, 0xe4, 0xe6, 0x24,
+  // LEVEL 08: RDLDRDRUDLURDLDRDRU
+  0xce, 0x6e, 0x93, 0xb3, 0x1b,
+  // LEVEL 09: RDLURDLU
+  0x4e, 0x4e,
+  // LEVEL 10: ULDRDRULULUR
+  0xb1, 0x1b, 0x91,
+  // LEVEL 11: DRURDLURDRULDRUL
+  0x9b, 0x93, 0x1b, 0x1b,
+  // LEVEL 12: DRULURDLURDLU
+  0x1b, 0x39, 0x39, 0x01,
+  // LEVEL 13: ULDRULDRULDLUR
+  0xb1, 0xb1, 0x31, 0x09,
+  // LEVEL 14: LURDRULDRURDLURDL
+  0xe4, 0xc6, 0xe6, 0xe4, 0x00,
+  // LEVEL 15: DLDRURDLUR
+  0xb3, 0x39, 0x09,
+  // LEVEL 16: DRULDLURDRULDRURDLUR
+  0x1b, 0x93, 0x1b, 0x9b, 0x93,
+  // LEVEL 17: RULDLDRURDLU
+  0xc6, 0x6c, 0x4e,
+  // LEVEL 18: RURDRURDRDLDLURDLURULD
+  0xe6, 0xe6, 0xce, 0xe4, 0x64, 0x0c,
+  // LEVEL 19: LURDLDRDLU
+  0xe4, 0xec, 0x04,
+  // LEVEL 20: DRURURURDRDLURDLULDLULDLDLUR
+  0x9b, 0x99, 0x3b, 0x39, 0x31, 0x31, 0x93,
+  // LEVEL 21: LULDRULURURULDRULURULURDRUL
+  0xc4, 0x46, 0x66, 0x6c, 0x64, 0xe4, 0x06,
+  // LEVEL 22: LURDLUR
+  0xe4, 0x24,
+  // LEVEL 23: RDLURULDRDLULDRDL
+  0x4e, 0xc6, 0x4e, 0xec, 0x00,
+  // LEVEL 24: LURDRULDLDRULURLDRULDRULUR
+  0xe4, 0xc6, 0x6c, 0x24, 0x1b, 0x1b, 0x09,
+  // LEVEL 25: LURDLDRURULURDLURDLUR
+  0xe4, 0x6c, 0x46, 0x4e, 0x4e, 0x02,
+  // LEVEL 26: LDRURDLDRURDLDRURDLUR
+  0x6c, 0xce, 0xe6, 0x6c, 0x4e, 0x02,
+  // LEVEL 27: URULDLURDLDLURULDLURDLU
+  0x19, 0x93, 0x33, 0x19, 0x93, 0x13,
+  // LEVEL 28: RDLURDLULURDRDLULURDLDLDLULULDR
+  0x4e, 0x4e, 0xe4, 0x4e, 0xe4, 0xcc, 0x44, 0x2c,
+  // LEVEL 29: DRDRDLULULDRDRDLULULDRDRDRUL
+  0xbb, 0x13, 0xb1, 0x3b, 0x11, 0xbb, 0x1b,
+  // LEVEL 30: RURURULDLURDRURULDRULDRDL
+  0x66, 0xc6, 0xe4, 0x66, 0x6c, 0xec, 0x00,
+  // LEVEL 31: RURDLDRURULRDLURUL
+  0xe6, 0x6c, 0x86, 0x93, 0x01,
+  // LEVEL 32: DRULURDLURDRULD
+  0x1b, 0x39, 0xb9, 0x31,
+  // LEVEL 33: URULURDLULDRDLULDRURDLURULDR
+  0x19, 0x39, 0xb1, 0x13, 0x9b, 0x93, 0xb1,
+  // LEVEL 34: LULURDLULURULDRDLURDRUL
+  0x44, 0x4e, 0x64, 0xec, 0xe4, 0x06,
+  // LEVEL 35: ULDRDLULDRULDRDLU
+  0xb1, 0x13, 0x1b, 0x3b, 0x01,
+  // LEVEL 36: DLURDRDLURDRDLDRULURDRU
+  0x93, 0x3b, 0xb9, 0xb3, 0x91, 0x1b,
+  // LEVEL 37: DLDRURDLDRURDRURDLDRURULD
+  0xb3, 0x39, 0x9b, 0x9b, 0xb3, 0x19, 0x03,
+  // LEVEL 38: DRURDLDRDLULURULDLURLDRULURDLUR
+  0x9b, 0xb3, 0x13, 0x19, 0x93, 0x6c, 0xe4, 0x24,
+  // LEVEL 39: LDLDRDLDRDLULDRDLURURDLURDLDLDRLUR
+  0xcc, 0xce, 0x4e, 0xec, 0x64, 0x4e, 0xce, 0x2c, 0x09,
+  // LEVEL 40: DRURURDRDLDRDLURULURULDLDLULDLURLDLUR
+  0x9b, 0xb9, 0xb3, 0x93, 0x91, 0x31, 0x13, 0x93, 0x4c, 0x02,
+};
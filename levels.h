@@ -1,6 +1,8 @@
 #define S 1
 #define G 2
 #define B 3
+#define H 4 // gate: stops pieces moving LEFT or RIGHT, they still slide through it UP or DOWN
+#define V 5 // gate: stops pieces moving UP or DOWN
 
 const uint8_t levelData[] PROGMEM = {
   // BEGINNER
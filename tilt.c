@@ -29,17 +29,20 @@
 #include <avr/pgmspace.h>
 #include <uzebox.h>
 #include <avr/interrupt.h>
+#include <util/atomic.h>
 
 #include "data/titlescreen.inc"
 #include "data/tileset.inc"
 #include "data/patches.inc"
 #include "levels.h"
+#include "levelbands.h"
+#include "levelhints.h"
+#include "tiltboard.h"
+#include "tiltslide.h"
 
 typedef struct {
   uint16_t held;
-  uint16_t prev;
   uint16_t pressed;
-  uint16_t released;
 } __attribute__ ((packed)) BUTTON_INFO;
 
 #define GAME_USER_RAM_TILES_COUNT 0
@@ -53,9 +56,9 @@ typedef struct {
 #define TILE_NUM_DPAD_RIGHT 6
 #define TILE_NUM_START_DIGITS 7
 
-#define BOARD_HEIGHT 5
-#define BOARD_WIDTH 5
+// BOARD_WIDTH, BOARD_HEIGHT and where the hole is come from tiltboard.h (see BOARD_WIDTH in the Makefile)
 #define LEVEL_SIZE (BOARD_WIDTH * BOARD_HEIGHT)
+#define NUM_LEVELS ((uint8_t)(sizeof(levelData) / LEVEL_SIZE))
 #define BOARD_OFFSET_IN_LEVEL 0
 
 #define ENTIRE_GAMEBOARD_LEFT ((SCREEN_TILES_H - MAP_BOARD_WIDTH) / 2)
@@ -68,20 +71,37 @@ typedef struct {
 uint8_t currentLevel;
 bool youWin;
 bool youLose;
+bool instantTilts; // INSTANT in the popup menu, every tilt lands without being animated
 
 // How many pieces hit their end stops this frame (affect whether the sfx plays and its volume)
 uint8_t numSlidersHitEndStops;
 bool playFellDownHoleSound;
 
-// The configuration of the playing board
-uint8_t board[BOARD_HEIGHT][BOARD_WIDTH] = {
-  {  0,  0,  0,  0,  0 },
-  {  0,  0,  0,  0,  0 },
-  {  0,  0,  0,  0,  0 },
-  {  0,  0,  0,  0,  0 },
-  {  0,  0,  0,  0,  0 },
+// What each cell of the board does to the pieces, fixed for the whole level (see LoadLevel)
+#define CELL_HOLE 0x01
+#define CELL_WALL 0x02              // a stopper, nothing ever moves onto it
+#define CELL_BLOCKS_HORIZONTAL 0x04 // a piece can't slide LEFT or RIGHT into, out of or through it (H)
+#define CELL_BLOCKS_VERTICAL 0x08   // the same, UP or DOWN (V)
+#define CELL_SHAPE_SHIFT 4          // the high bits pick its tile maps (see pieceTileMaps)
+#define CELL_SHAPE_GATE_H BOARD_CELL_SHAPES
+#define CELL_SHAPE_GATE_V (BOARD_CELL_SHAPES + 1)
+#define CELL_SHAPES (BOARD_CELL_SHAPES + 2)
+
+// Indexed by the cell values in levels.h: 0, S, G, B, H, V
+const uint8_t cellValueProperties[] PROGMEM = {
+  0,
+  CELL_WALL,
+  0,
+  0,
+  CELL_BLOCKS_HORIZONTAL | (CELL_SHAPE_GATE_H << CELL_SHAPE_SHIFT),
+  CELL_BLOCKS_VERTICAL | (CELL_SHAPE_GATE_V << CELL_SHAPE_SHIFT),
 };
 
+uint8_t cellProperties[BOARD_HEIGHT][BOARD_WIDTH];
+
+// The configuration of the playing board (0, S, G or B, gates are only in cellProperties)
+uint8_t board[BOARD_HEIGHT][BOARD_WIDTH];
+
 typedef struct {
   // Board start/end state when tilting in a direction
   uint8_t piece; // G or B
@@ -93,75 +113,430 @@ typedef struct {
 
   // Animation stuff
   bool doneMoving;
-  int16_t x;
-  int16_t y;
-  int16_t dx;
-  int16_t dy;
+  uint8_t sprite; // the first of its sprites, or one of the MOVE_* states below
+  uint8_t tileX;  // where a piece without sprites is drawn, in screen tiles
+  uint8_t tileY;
+  uint8_t frame;        // frames since it started sliding
+  uint8_t landingFrame; // the frame it stops on (see tiltslide.h)
 } __attribute__ ((packed)) MOVE_INFO;
 
-#define MAX_MOVABLE_PIECES 5
+// Greens and blues on one board, the same as TILT_MAX_MOVABLE_PIECES in tools/tiltengine.h
+#define MAX_MOVABLE_PIECES 10
 MOVE_INFO moveInfo[MAX_MOVABLE_PIECES];
 
-// Each piece has a different tile map if it partially overlaps with the hole in the center of the board
+#define MOVE_TILES 0xFF   // moves a whole tile at a time without any sprites (see MovePieceTiles)
+#define MOVE_WAITING 0xFE // held back until its line fits in the ram tiles (see StartWaitingLines)
+#define MOVE_SETTLED 0xFD // drawn with tiles where it ends up
+
+// What the sprites of the moving pieces have to share (see RamTiles_Measure)
+#define SPRITE_RAM_TILES (RAM_TILES_COUNT - GAME_USER_RAM_TILES_COUNT)
+#define SPRITE_PIECES (MAX_SPRITES / (GAMEPIECE_WIDTH * GAMEPIECE_HEIGHT))
+
+// Pieces sliding into the end stops (or the hole) at the same time only get louder up to this many
+#define SFX_LOUDEST_SLIDERS 5
+
+// One bit per cell (see BOARD_MASK_ALL)
+#if LEVEL_SIZE <= 32
+typedef uint32_t BOARD_BITS;
+#else
+typedef uint64_t BOARD_BITS;
+#endif
+
+// A board packed by Search_Pack, which needs room for a color bit per piece on top of the cells (see Search_Begin)
+#if LEVEL_SIZE + MAX_MOVABLE_PIECES <= 32
+typedef uint32_t SEARCH_KEY;
+#else
+typedef uint64_t SEARCH_KEY;
+#endif
+
+// The cells that stop pieces when tilting along each axis: the stoppers, plus the gates across that axis
+typedef struct {
+  BOARD_BITS horizontal; // LEFT and RIGHT
+  BOARD_BITS vertical;   // UP and DOWN
+} __attribute__ ((packed)) BOARD_WALLS;
+
+// Only the pieces that move, the stoppers are the same for every state of a level
+typedef struct {
+  BOARD_BITS greens;
+  BOARD_BITS blues;
+} __attribute__ ((packed)) HINT_STATE;
+
+typedef struct {
+  HINT_STATE state;
+  uint8_t firstMove; // the tilt from the current board that leads here
+} __attribute__ ((packed)) HINT_NODE;
+
+// What GetHint works in, kept off the stack
+#define HINT_SEARCH_NODES 24
+// Every tilt the search off the path may make, replaying the path to check a fingerprint included (see GetHint)
+#define HINT_SEARCH_TILTS (HINT_SEARCH_NODES * 4 + 2 * LEVEL_HINTS_MAX_LENGTH)
+typedef struct {
+  uint16_t path[LEVEL_HINTS_MAX_LENGTH]; // a fingerprint of each board along the stored solution
+  HINT_NODE nodes[HINT_SEARCH_NODES];
+} __attribute__ ((packed)) HINT_SCRATCH;
+
+// Breadth-first search for a win from one board, run a slice at a time in idle frame time (see Search_Step).
+// Looking for dead ends on the current board comes first, generating the next endless mode level gets what is left.
+#define SEARCH_WORDS 64 // boards that fit in 32 bits take one, the rest take two
+#define SEARCH_NODES_PER_FRAME 2 // while playing
+#define SEARCH_NODES_PER_IDLE_FRAME 8 // while the PASS/FAIL screen waits for START
+
+#define SEARCH_START 0    // the board changed, look for a dead end on it next step
+#define SEARCH_RUNNING 1
+#define SEARCH_WINNABLE 2 // found a way to win, 'depth' tilts long
+#define SEARCH_LOST 3     // every reachable board was seen, and none of them wins
+#define SEARCH_GAVE_UP 4  // too many reachable boards to tell
+#define SEARCH_IDLE 5     // the game is already won or lost
+
+#define SEARCH_FOR_STUCK 0   // on the board being played
+#define SEARCH_FOR_ENDLESS 1 // on a candidate for the next endless mode level
+
+typedef struct {
+  uint8_t status;
+  uint8_t owner;
+  uint8_t head;     // next board to expand
+  uint8_t tail;     // boards seen so far, in the order they were found
+  uint8_t layerEnd; // first board that is one tilt further away than the board at 'head'
+  uint8_t depth;    // tilts from the start to the board at 'head'
+  uint8_t capacity; // boards the table holds, most dead ends reach fewer than this and the rest are given up on
+  bool wide;        // each board takes two words of the table
+  BOARD_WALLS walls; // the table itself is scratch.states, in borrowed ram tiles (see SCRATCH)
+} __attribute__ ((packed)) BOARD_SEARCH;
+
+BOARD_SEARCH search;
+
+// Levels made up on the device once levels.h runs out (see Endless_Step)
+#define ENDLESS_SEED 0xACE1
+#define ENDLESS_MIN_MOVES 8
+#define ENDLESS_LAST_LEVEL 99 // PUZZLE ## only has two digits
+#define ENDLESS_MAX_PIECES 5   // more than this and most candidates reach too many boards for the search
+#define ENDLESS_MAX_WAIT 90    // frames WAIT stays up before a built-in level is reused (see Endless_Fallback)
+// Symmetries of the board that keep the hole where it is, for Endless_Fallback
+#define ENDLESS_MIRROR_X (BOARD_HOLE_X * 2 == BOARD_WIDTH - 1)
+#define ENDLESS_MIRROR_Y (BOARD_HOLE_Y * 2 == BOARD_HEIGHT - 1)
+#define ENDLESS_TRANSPOSE (BOARD_WIDTH == BOARD_HEIGHT && BOARD_HOLE_X == BOARD_HOLE_Y)
+
+typedef struct {
+  uint16_t random;
+  bool pending; // the next level is waiting on the search
+  bool ready;   // the next level has been accepted, and is held in reserve until PASS is confirmed
+  uint8_t moves; // tilts needed to win the next level
+  uint8_t band;  // of the endless level being played, by the length of its solution
+  BOARD_BITS stoppers;
+  BOARD_BITS greens;
+  BOARD_BITS blues;
+  uint8_t cells[LEVEL_SIZE]; // the endless level being played
+} __attribute__ ((packed)) ENDLESS;
+
+ENDLESS endless = { .random = ENDLESS_SEED };
+bool stuckShown;
+
+// Each piece has a different tile map if it partially overlaps with the hole, indexed by piece then by the
+// shape in cellProperties (boardCellShapes, or one of the gates, which a piece on top of covers up)
+const VRAM_PTR_TYPE* const pieceTileMaps[4][CELL_SHAPES] PROGMEM = {
+  { map_grid, map_grid_t, map_grid_l, map_grid_r, map_grid_b, map_grid, map_gate_h, map_gate_v },                // empty
+  { map_stopper, map_stopper_t, map_stopper_l, map_stopper_r, map_stopper_b, map_stopper, map_stopper, map_stopper }, // S
+  { map_green, map_green_t, map_green_l, map_green_r, map_green_b, map_green_h, map_green, map_green },          // G
+  { map_blue, map_blue_t, map_blue_l, map_blue_r, map_blue_b, map_blue_h, map_blue, map_blue },                  // B
+};
+
 static const VRAM_PTR_TYPE* MapPieceToTileMapForBoardPosition(uint8_t piece, uint8_t x, uint8_t y) {
-  const VRAM_PTR_TYPE* map_piece = map_stopper;
-  switch (piece) {
-  case S:
-    if (x == 2 && y == 1)
-      map_piece = map_stopper_t;
-    else if (x == 1 && y == 2)
-      map_piece = map_stopper_l;
-    else if (x == 3 && y == 2)
-      map_piece = map_stopper_r;
-    else if (x == 2 && y == 3)
-      map_piece = map_stopper_b;
-    else
-      map_piece = map_stopper;
-    break;
-  case G:
-    if (x == 2 && y == 1)
-      map_piece = map_green_t;
-    else if (x == 1 && y == 2)
-      map_piece = map_green_l;
-    else if (x == 3 && y == 2)
-      map_piece = map_green_r;
-    else if (x == 2 && y == 3)
-      map_piece = map_green_b;
-    else if (x == 2 && y == 2)
-      map_piece = map_green_h;
-    else
-      map_piece = map_green;
-    break;
-  case B:
-    if (x == 2 && y == 1)
-      map_piece = map_blue_t;
-    else if (x == 1 && y == 2)
-      map_piece = map_blue_l;
-    else if (x == 3 && y == 2)
-      map_piece = map_blue_r;
-    else if (x == 2 && y == 3)
-      map_piece = map_blue_b;
-    else if (x == 2 && y == 2)
-      map_piece = map_blue_h;
-    else
-      map_piece = map_blue;
-    break;
-  }
-  return map_piece;
+  uint8_t shape = cellProperties[y][x] >> CELL_SHAPE_SHIFT;
+  return (const VRAM_PTR_TYPE*)pgm_read_word(&pieceTileMaps[piece][shape]);
 }
 
 // Returns the empty tile map for a given board position
 static const VRAM_PTR_TYPE* MapBoardPositionToGridTileMap(uint8_t x, uint8_t y) {
-  const VRAM_PTR_TYPE* map_piece = map_grid;
-  if (x == 2 && y == 1)
-    map_piece = map_grid_t;
-  else if (x == 1 && y == 2)
-    map_piece = map_grid_l;
-  else if (x == 3 && y == 2)
-    map_piece = map_grid_r;
-  else if (x == 2 && y == 3)
-    map_piece = map_grid_b;
-  return map_piece;
+  return MapPieceToTileMapForBoardPosition(0, x, y);
+}
+
+/*
+ * Deferred VRAM writes
+ *
+ * The game screen doesn't write tiles straight into vram, where a write that lands while the screen is
+ * being drawn shows up half done. They go into vramQueue instead, and Vram_WaitVsync writes them out
+ * right after the vertical sync, in the blank lines before the next frame starts. A frame only takes
+ * VRAM_TILES_PER_VBLANK of them (give or take a row), so a big redraw is spread over a few frames, and
+ * a full queue waits for the next one. Anything that reads vram back has to Vram_Finish first.
+ */
+#define VRAM_QUEUE_LENGTH 16 // a power of 2
+#define VRAM_TILES_PER_VBLANK 128
+
+#define VRAM_FILL 0         // every tile of the rectangle is 'tile'
+#define VRAM_FILL_RAM 1     // the same with a ram tile
+#define VRAM_MAP 2          // rows of tiles from flash, like DrawMap
+#define VRAM_COPY 3         // rows of raw vram bytes from ram, a whole row at a time (see Window_Close)
+#define VRAM_TEXT 4         // one row of ram tiles from flash, negative ones are skipped (see RamFont_Print)
+#define VRAM_TEXT_MINUS_A 5 // the same, with 'A' as ram tile 0 (see RamFont_Print_Minus_A)
+
+typedef struct {
+  uint8_t op; // VRAM_*
+  uint8_t x;
+  uint8_t y;
+  uint8_t w;
+  uint8_t h;  // rows still to write
+  union {
+    uint16_t tile;
+    const uint8_t* src; // the next row to write
+  };
+} __attribute__ ((packed)) VRAM_COMMAND;
+
+typedef struct {
+  VRAM_COMMAND commands[VRAM_QUEUE_LENGTH];
+  uint8_t head; // the next command to write out
+  uint8_t tail; // where the next command goes
+} __attribute__ ((packed)) VRAM_QUEUE;
+
+VRAM_QUEUE vramQueue;
+
+// Writes out queued commands a row at a time, until about 'budget' tiles have been written
+static void Vram_Flush(uint8_t budget)
+{
+  while (vramQueue.head != vramQueue.tail) {
+    VRAM_COMMAND* c = &vramQueue.commands[vramQueue.head];
+    if (c->op == VRAM_COPY)
+      memcpy(&vram[c->y * VRAM_TILES_H + c->x], c->src, c->w);
+    else {
+      for (uint8_t i = 0; i < c->w; ++i) {
+        uint8_t x = c->x + i;
+        int8_t tileno;
+        switch (c->op) {
+        case VRAM_FILL:
+          SetTile(x, c->y, c->tile);
+          break;
+        case VRAM_FILL_RAM:
+          SetRamTile(x, c->y, c->tile);
+          break;
+        case VRAM_MAP:
+          SetTile(x, c->y, (uint8_t)pgm_read_byte(&c->src[i]));
+          break;
+        case VRAM_TEXT:
+          tileno = (int8_t)pgm_read_byte(&c->src[i]);
+          if (tileno >= 0)
+            SetRamTile(x, c->y, tileno);
+          break;
+        case VRAM_TEXT_MINUS_A:
+          tileno = (int8_t)pgm_read_byte(&c->src[i]);
+          if (tileno >= 0)
+            SetRamTile(x, c->y, tileno - 'A');
+          break;
+        }
+      }
+    }
+
+    uint8_t written = c->w;
+    ++c->y;
+    if (c->op >= VRAM_MAP)
+      c->src += c->w;
+    if (--c->h == 0)
+      vramQueue.head = (vramQueue.head + 1) & (VRAM_QUEUE_LENGTH - 1);
+    if (written >= budget)
+      break;
+    budget -= written;
+  }
+}
+
+// Use instead of WaitVsync(1) on the game screen
+static void Vram_WaitVsync(void)
+{
+  WaitVsync(1);
+  Vram_Flush(VRAM_TILES_PER_VBLANK);
+}
+
+// Waits until everything queued is on screen
+static void Vram_Finish(void)
+{
+  while (vramQueue.head != vramQueue.tail)
+    Vram_WaitVsync();
+}
+
+// Forgets everything queued, for when the screen is about to be cleared anyway
+static void Vram_Discard(void)
+{
+  vramQueue.head = vramQueue.tail;
+}
+
+static void Vram_Push(uint8_t op, uint8_t x, uint8_t y, uint8_t w, uint8_t h, uint16_t tile, const uint8_t* src)
+{
+  while (((vramQueue.tail + 1) & (VRAM_QUEUE_LENGTH - 1)) == vramQueue.head)
+    Vram_WaitVsync();
+
+  VRAM_COMMAND* c = &vramQueue.commands[vramQueue.tail];
+  c->op = op;
+  c->x = x;
+  c->y = y;
+  c->w = w;
+  c->h = h;
+  if (op >= VRAM_MAP)
+    c->src = src;
+  else
+    c->tile = tile;
+  vramQueue.tail = (vramQueue.tail + 1) & (VRAM_QUEUE_LENGTH - 1);
+}
+
+static void Vram_SetTile(uint8_t x, uint8_t y, uint8_t tile)
+{
+  Vram_Push(VRAM_FILL, x, y, 1, 1, tile, 0);
+}
+
+static void Vram_SetRamTile(uint8_t x, uint8_t y, uint8_t tile)
+{
+  Vram_Push(VRAM_FILL_RAM, x, y, 1, 1, tile, 0);
+}
+
+static void Vram_DrawMap(uint8_t x, uint8_t y, const VRAM_PTR_TYPE* map)
+{
+  Vram_Push(VRAM_MAP, x, y, (uint8_t)pgm_read_byte(&map[0]), (uint8_t)pgm_read_byte(&map[1]), 0, (const uint8_t*)&map[2]);
+}
+
+/*
+ * Overlay windows
+ *
+ * A window is drawn over the game screen for a while and then taken down again. Window_Open copies
+ * the vram under it into scratch.backing a whole row at a time, and Window_Close queues those rows
+ * to be copied back, so nothing under it has to be redrawn. Windows stack, only the top one can be
+ * closed, and all the windows open at once have to fit in WINDOW_BACKING_SIZE tiles. Each window checks
+ * its own size against that when it is built, and Window_Open refuses one that doesn't fit on the stack.
+ */
+#define WINDOW_STACK_DEPTH 2
+#define WINDOW_BACKING_SIZE 128
+
+typedef struct {
+  uint8_t x; // in vram tiles
+  uint8_t y;
+  uint8_t w;
+  uint8_t h;
+  uint8_t backing; // where its rows start in scratch.backing
+} __attribute__ ((packed)) WINDOW;
+
+typedef struct {
+  WINDOW windows[WINDOW_STACK_DEPTH];
+  uint8_t count;
+  uint8_t refused; // windows opened on top that didn't fit, which draw and close as nothing
+} __attribute__ ((packed)) WINDOW_STACK;
+
+WINDOW_STACK windowStack;
+
+/*
+ * Borrowed ram tiles
+ *
+ * The search table, GetHint's scratch space and the window backing don't fit in RAM next to vram and
+ * the ram tiles, so they live in the last SCRATCH_RAM_TILES ram tiles instead. Nothing else uses those
+ * outside the title and how to play screens, except the sprites of a tilt, and AnimateBoard doesn't
+ * return until the sprites are out of them. The three take turns: GetHint runs just before the popup
+ * menu's window opens, and the search starts over after both (see GetHint). A window no bigger than
+ * SCRATCH_SMALL_WINDOW, like PASS/FAIL, leaves the search table alone so the search keeps running.
+ */
+#define SCRATCH_RAM_TILES 5
+#define SCRATCH_FIRST_RAM_TILE (RAM_TILES_COUNT - SCRATCH_RAM_TILES)
+#define SCRATCH_SMALL_WINDOW 64
+
+typedef union {
+  HINT_SCRATCH hint;
+  uint8_t backing[WINDOW_BACKING_SIZE]; // raw vram bytes of the open windows, ram tiles and all
+  struct {
+    uint8_t smallWindows[SCRATCH_SMALL_WINDOW];
+    uint32_t states[SEARCH_WORDS]; // see Search_Pack
+  } __attribute__ ((packed));
+} SCRATCH;
+
+_Static_assert(sizeof(SCRATCH) <= SCRATCH_RAM_TILES * TILE_WIDTH * TILE_HEIGHT, "SCRATCH needs more ram tiles");
+
+#define scratch (*(SCRATCH*)&ram_tiles[SCRATCH_FIRST_RAM_TILE * TILE_WIDTH * TILE_HEIGHT])
+
+// Returns false, leaving the screen alone, if the stack is full or the window doesn't fit in what is left of
+// the backing. It still has to be closed, and until then nothing else can be opened on top of it.
+static bool Window_Open(uint8_t x, uint8_t y, uint8_t w, uint8_t h)
+{
+  uint16_t backingStart = 0;
+  if (windowStack.count) {
+    const WINDOW* under = &windowStack.windows[windowStack.count - 1];
+    backingStart = under->backing + under->w * under->h;
+  }
+  if (windowStack.refused || windowStack.count == WINDOW_STACK_DEPTH || backingStart + w * h > WINDOW_BACKING_SIZE) {
+    ++windowStack.refused;
+    return false;
+  }
+
+  WINDOW* win = &windowStack.windows[windowStack.count++];
+  win->x = x;
+  win->y = y;
+  win->w = w;
+  win->h = h;
+  win->backing = (uint8_t)backingStart;
+
+  // What is under it has to be on screen before it can be saved, and that includes any window just closed
+  Vram_Finish();
+  uint8_t* backing = &scratch.backing[win->backing];
+  for (uint8_t row = 0; row < h; ++row, backing += w)
+    memcpy(backing, &vram[(y + row) * VRAM_TILES_H + x], w);
+  return true;
+}
+
+// Fills the top window with 'tile' inside a border of 8 ram tiles starting at 'border', in the order
+// top left, top, top right, left, right, bottom left, bottom, bottom right (see rf_popup_border)
+static void Window_DrawFrame(uint8_t border, uint8_t tile)
+{
+  if (windowStack.refused)
+    return;
+  const WINDOW* win = &windowStack.windows[windowStack.count - 1];
+  uint8_t right = win->x + win->w - 1;
+  uint8_t bottom = win->y + win->h - 1;
+  Vram_Push(VRAM_FILL, win->x + 1, win->y + 1, win->w - 2, win->h - 2, tile, 0);
+  Vram_SetRamTile(win->x, win->y, border);
+  Vram_Push(VRAM_FILL_RAM, win->x + 1, win->y, win->w - 2, 1, border + 1, 0);
+  Vram_SetRamTile(right, win->y, border + 2);
+  Vram_Push(VRAM_FILL_RAM, win->x, win->y + 1, 1, win->h - 2, border + 3, 0);
+  Vram_Push(VRAM_FILL_RAM, right, win->y + 1, 1, win->h - 2, border + 4, 0);
+  Vram_SetRamTile(win->x, bottom, border + 5);
+  Vram_Push(VRAM_FILL_RAM, win->x + 1, bottom, win->w - 2, 1, border + 6, 0);
+  Vram_SetRamTile(right, bottom, border + 7);
+}
+
+// Queues what was under the top window to be put back, Vram_Finish to be sure it is on screen
+static void Window_Close(void)
+{
+  if (windowStack.refused) {
+    --windowStack.refused;
+    return;
+  }
+  const WINDOW* win = &windowStack.windows[--windowStack.count];
+  Vram_Push(VRAM_COPY, win->x, win->y, win->w, win->h, 0, &scratch.backing[win->backing]);
+}
+
+/*
+ * Board rendering
+ *
+ * shownCells remembers the tile map each cell of the board was last drawn with, so redrawing the board
+ * only writes the cells that actually changed. Loading the next level, RESET TOKENS and retrying after
+ * FAIL then cost a handful of cells instead of the whole board. Anything that draws over a cell without
+ * going through Render_Cell has to say what it left there, and a cleared screen forgets everything.
+ */
+#define RENDER_UNKNOWN 0xFF
+#define RENDER_CODE(x, y, piece) ((cellProperties[y][x] & (0xFF << CELL_SHAPE_SHIFT)) | (piece))
+
+uint8_t shownCells[BOARD_HEIGHT][BOARD_WIDTH];
+uint8_t shownLevel;  // the level number above the board, 0 before the board has been drawn at all
+uint8_t shownStripe; // the difficulty stripe tile under it
+
+// Call after ClearVram, so the next LoadLevel draws everything
+static void Render_Invalidate(void)
+{
+  memset(shownCells, RENDER_UNKNOWN, sizeof(shownCells));
+  shownLevel = 0;
+  shownStripe = RENDER_UNKNOWN;
+}
+
+// Draws a piece (or 0 for none) on a cell, unless that is what it already shows
+static void Render_Cell(uint8_t x, uint8_t y, uint8_t piece)
+{
+  uint8_t code = RENDER_CODE(x, y, piece);
+  if (shownCells[y][x] == code)
+    return;
+  shownCells[y][x] = code;
+  Vram_DrawMap(GAMEBOARD_ACTIVE_AREA_LEFT + x * GAMEPIECE_WIDTH,
+          GAMEBOARD_ACTIVE_AREA_TOP + y * GAMEPIECE_HEIGHT,
+          MapPieceToTileMapForBoardPosition(piece, x, y));
 }
 
 /*
@@ -224,231 +599,273 @@ static bool BCD_addConstant(uint8_t* const num, const uint8_t digits, uint8_t x)
   return false;
 }
 
+// Bands come from levelbands.h, which tools/difficulty generates by measuring how hard each level actually plays.
+// Endless mode levels are banded by the length of their solution instead.
+static uint8_t GetBandForLevel(uint8_t level)
+{
+  if (level > NUM_LEVELS)
+    return endless.band;
+  return (uint8_t)pgm_read_byte(&levelBands[level - 1]);
+}
+
 static uint8_t GetDifficultyTileForLevel(uint8_t level)
 {
-  if ((level >= 1) && (level <= 10))
-    return TILE_NUM_GREEN;
-  else if ((level >= 11) && (level <= 20))
-    return TILE_NUM_YELLOW;
-  else if ((level >= 21) && (level <= 30))
-    return TILE_NUM_BLUE;
-  else if ((level >= 31) && (level <= 40))
-    return TILE_NUM_RED;
+  if (level >= 1)
+    return TILE_NUM_GREEN + GetBandForLevel(level); // GREEN, YELLOW, BLUE, RED
   return 0;
 }
 
-static void LoadLevel(const uint8_t level)
+// Sets up the board for a level without drawing anything
+static void SetUpLevel(const uint8_t level)
 {
   youWin = false;
   youLose = false;
-
-  // Draw PUZZLE ##
-  DrawMap(ENTIRE_GAMEBOARD_LEFT, ENTIRE_GAMEBOARD_TOP - 3, map_tilt_puzzle);
-  uint8_t digits[2] = {0};
-  BCD_addConstant(digits, 2, level);
-  SetTile(ENTIRE_GAMEBOARD_LEFT + MAP_TILT_PUZZLE_WIDTH + 1, ENTIRE_GAMEBOARD_TOP - 3, TILE_NUM_START_DIGITS + digits[1]);
-  SetTile(ENTIRE_GAMEBOARD_LEFT + MAP_TILT_PUZZLE_WIDTH + 2, ENTIRE_GAMEBOARD_TOP - 3, TILE_NUM_START_DIGITS + digits[0]);
-
-  uint8_t difficultyStripe = GetDifficultyTileForLevel(level);
-  for (uint8_t i = ENTIRE_GAMEBOARD_LEFT; i < ENTIRE_GAMEBOARD_LEFT + MAP_BOARD_WIDTH; ++i)
-    SetTile(i, ENTIRE_GAMEBOARD_TOP - 2, difficultyStripe);
-
-  DrawMap(ENTIRE_GAMEBOARD_LEFT, ENTIRE_GAMEBOARD_TOP, map_board);
+  search.status = SEARCH_START;
 
   const uint16_t levelOffset = (level - 1) * LEVEL_SIZE;
   for (uint8_t y = 0; y < BOARD_HEIGHT; ++y)
     for (uint8_t x = 0; x < BOARD_WIDTH; ++x) {
-      uint8_t piece = (uint8_t)pgm_read_byte(&levelData[(levelOffset + BOARD_OFFSET_IN_LEVEL) + y * BOARD_WIDTH + x]);
+      uint8_t piece = (level > NUM_LEVELS) ? endless.cells[y * BOARD_WIDTH + x] :
+        (uint8_t)pgm_read_byte(&levelData[(levelOffset + BOARD_OFFSET_IN_LEVEL) + y * BOARD_WIDTH + x]);
+
+      uint8_t properties = (uint8_t)pgm_read_byte(&cellValueProperties[piece]);
+      if (!(properties >> CELL_SHAPE_SHIFT))
+        properties |= (uint8_t)pgm_read_byte(&boardCellShapes[y * BOARD_WIDTH + x]) << CELL_SHAPE_SHIFT;
+      if (x == BOARD_HOLE_X && y == BOARD_HOLE_Y)
+        properties |= CELL_HOLE;
+      cellProperties[y][x] = properties;
+
+      if (piece == H || piece == V)
+        piece = 0;
       board[y][x] = piece;
-
-      if (piece == S || piece == G || piece == B)
-        DrawMap(GAMEBOARD_ACTIVE_AREA_LEFT + x * GAMEPIECE_WIDTH,
-                GAMEBOARD_ACTIVE_AREA_TOP + y * GAMEPIECE_HEIGHT,
-                MapPieceToTileMapForBoardPosition(piece, x, y));
     }
 }
 
-static void TiltBoardLeft() {
-  memset(moveInfo, 0, MAX_MOVABLE_PIECES * sizeof(MOVE_INFO));
-  uint8_t currentIndex = 0;
-
-  // Start from the leftmost column, and work our way right, looping over each row
-  for (uint8_t x = 0; x < BOARD_WIDTH; ++x)
-    for (uint8_t y = 0; y < BOARD_HEIGHT; ++y)
-      if (board[y][x] == G || board[y][x] == B) {
-        moveInfo[currentIndex].piece = board[y][x];
-        moveInfo[currentIndex].xStart = x;
-        moveInfo[currentIndex].yStart = y;
-        moveInfo[currentIndex].yEnd = y;
-
-        // Decrement xEnd until we hit a stopper or the edge, adding the number of G's and B's along the way
-        uint8_t numGreenBlueSeen = 0;
-        uint8_t xEnd = x;
-
-        while (xEnd > 0) {
-          uint8_t nextPiece = board[y][xEnd - 1];
-
-          if (nextPiece == S)
-            break;
-
-          if (xEnd - 1 == 2 && y == 2) {
-            moveInfo[currentIndex].fellDownHole = true;
-            if (moveInfo[currentIndex].piece == B)
-              youLose = true;
-            break;
-          }
+static uint8_t LevelNumberTile(uint8_t level, uint8_t digit)
+{
+  uint8_t digits[2] = {0};
+  BCD_addConstant(digits, 2, level);
+  return TILE_NUM_START_DIGITS + digits[digit];
+}
 
-          if (nextPiece == G || nextPiece == B)
-            ++numGreenBlueSeen;
+#define LEVEL_NUMBER_X (ENTIRE_GAMEBOARD_LEFT + MAP_TILT_PUZZLE_WIDTH + 1)
+#define LEVEL_NUMBER_Y (ENTIRE_GAMEBOARD_TOP - 3)
+#define DIFFICULTY_STRIPE_Y (ENTIRE_GAMEBOARD_TOP - 2)
 
-          --xEnd;
-        }
+static void LoadLevel(const uint8_t level)
+{
+  SetUpLevel(level);
 
-        if (moveInfo[currentIndex].fellDownHole)
-          moveInfo[currentIndex].xEnd = 2;
-        else
-          moveInfo[currentIndex].xEnd = xEnd + numGreenBlueSeen;
+  // The frame around the board only has to be drawn once
+  if (!shownLevel) {
+    Vram_DrawMap(ENTIRE_GAMEBOARD_LEFT, ENTIRE_GAMEBOARD_TOP - 3, map_tilt_puzzle);
+    Vram_DrawMap(ENTIRE_GAMEBOARD_LEFT, ENTIRE_GAMEBOARD_TOP, map_board);
+  }
 
-        if (currentIndex < MAX_MOVABLE_PIECES - 1)
-          ++currentIndex;
-      }
-}
+  // Draw PUZZLE ##
+  if (level != shownLevel) {
+    Vram_SetTile(LEVEL_NUMBER_X, LEVEL_NUMBER_Y, LevelNumberTile(level, 1));
+    Vram_SetTile(LEVEL_NUMBER_X + 1, LEVEL_NUMBER_Y, LevelNumberTile(level, 0));
+    shownLevel = level;
+  }
 
-static void TiltBoardUp() {
-  memset(moveInfo, 0, MAX_MOVABLE_PIECES * sizeof(MOVE_INFO));
-  uint8_t currentIndex = 0;
+  uint8_t difficultyStripe = GetDifficultyTileForLevel(level);
+  if (difficultyStripe != shownStripe) {
+    Vram_Push(VRAM_FILL, ENTIRE_GAMEBOARD_LEFT, DIFFICULTY_STRIPE_Y, MAP_BOARD_WIDTH, 1, difficultyStripe, 0);
+    shownStripe = difficultyStripe;
+  }
 
-  // Start from the topmost row, and work our way down, looping over each column
   for (uint8_t y = 0; y < BOARD_HEIGHT; ++y)
     for (uint8_t x = 0; x < BOARD_WIDTH; ++x)
-      if (board[y][x] == G || board[y][x] == B) {
-        moveInfo[currentIndex].piece = board[y][x];
-        moveInfo[currentIndex].xStart = x;
-        moveInfo[currentIndex].yStart = y;
-        moveInfo[currentIndex].xEnd = x;
-        // Decrement yEnd until we hit a stopper or the edge, adding the number of G's and B's along the way
-        uint8_t numGreenBlueSeen = 0;
-        uint8_t yEnd = y;
-
-        while (yEnd > 0) {
-          uint8_t nextPiece = board[yEnd - 1][x];
-
-          if (nextPiece == S)
-            break;
-
-          if (yEnd - 1 == 2 && x == 2) {
-            moveInfo[currentIndex].fellDownHole = true;
-            if (moveInfo[currentIndex].piece == B)
-              youLose = true;
-            break;
-          }
-
-          if (nextPiece == G || nextPiece == B)
-            ++numGreenBlueSeen;
-
-          --yEnd;
-        }
-
-        if (moveInfo[currentIndex].fellDownHole)
-          moveInfo[currentIndex].yEnd = 2;
-        else
-          moveInfo[currentIndex].yEnd = yEnd + numGreenBlueSeen;
-
-        if (currentIndex < MAX_MOVABLE_PIECES - 1)
-          ++currentIndex;
-      }
+      Render_Cell(x, y, board[y][x]);
 }
 
-static void TiltBoardRight() {
-  memset(moveInfo, 0, MAX_MOVABLE_PIECES * sizeof(MOVE_INFO));
-  uint8_t currentIndex = 0;
-
-  // Start from the rightmost column, and work our way left, looping over each row
-  for (uint8_t x = BOARD_WIDTH - 1; x != 255; --x)
-    for (uint8_t y = 0; y < BOARD_HEIGHT; ++y)
-      if (board[y][x] == G || board[y][x] == B) {
-        moveInfo[currentIndex].piece = board[y][x];
-        moveInfo[currentIndex].xStart = x;
-        moveInfo[currentIndex].yStart = y;
-        moveInfo[currentIndex].yEnd = y;
-
-        // Increment xEnd until we hit a stopper or the edge, subtracting the number of G's and B's along the way
-        uint8_t numGreenBlueSeen = 0;
-        uint8_t xEnd = x;
+#if SCROLLING
+/*
+ * Level transitions
+ *
+ * vram is VRAM_TILES_H wide, a couple of columns more than the screen, and mode 3 scrolling wraps around
+ * it. A transition scrolls the whole screen left by the full width of vram, which lands it right back
+ * where it started. Each column is redrawn for the new level as soon as it has scrolled off the left
+ * edge, while it is one of the columns that are never on screen, so the old board slides out and the new
+ * one slides in behind it. Only what differs is drawn, a column at a time, spread over the whole slide.
+ * Transition_Step moves it along by one frame, from STATE_SLIDE (see SlideToLevel).
+ */
+#define TRANSITION_PIXELS_PER_FRAME 8 // at most a tile, or a column could come back on screen before it is drawn
 
-        while (xEnd < BOARD_WIDTH - 1) {
-          uint8_t nextPiece = board[y][xEnd + 1];
+typedef struct {
+  uint8_t level;
+  uint8_t difficultyStripe;
+  uint8_t scroll; // pixels, wraps around with the vram
+  uint8_t column; // the next one to draw
+} __attribute__ ((packed)) TRANSITION;
 
-          if (nextPiece == S)
-            break;
+TRANSITION transition;
 
-          if (xEnd + 1 == 2 && y == 2) {
-            moveInfo[currentIndex].fellDownHole = true;
-            if (moveInfo[currentIndex].piece == B)
-              youLose = true;
-            break;
-          }
+#if VRAM_TILES_H <= SCREEN_TILES_H
+#error Level transitions need vram wider than the screen
+#endif
 
-          if (nextPiece == G || nextPiece == B)
-            ++numGreenBlueSeen;
+// Draws what the new level has in one column of vram, which has to be off screen
+static void Transition_DrawColumn(uint8_t x, uint8_t level, uint8_t difficultyStripe)
+{
+  if (x >= ENTIRE_GAMEBOARD_LEFT && x < ENTIRE_GAMEBOARD_LEFT + MAP_BOARD_WIDTH && difficultyStripe != shownStripe)
+    Vram_SetTile(x, DIFFICULTY_STRIPE_Y, difficultyStripe);
+  if ((x == LEVEL_NUMBER_X || x == LEVEL_NUMBER_X + 1) && level != shownLevel)
+    Vram_SetTile(x, LEVEL_NUMBER_Y, LevelNumberTile(level, LEVEL_NUMBER_X + 1 - x));
 
-          ++xEnd;
-        }
+  if (x < GAMEBOARD_ACTIVE_AREA_LEFT || x >= GAMEBOARD_ACTIVE_AREA_LEFT + BOARD_WIDTH * GAMEPIECE_WIDTH)
+    return;
+  uint8_t cellX = (x - GAMEBOARD_ACTIVE_AREA_LEFT) / GAMEPIECE_WIDTH;
+  uint8_t column = (x - GAMEBOARD_ACTIVE_AREA_LEFT) % GAMEPIECE_WIDTH;
+  for (uint8_t y = 0; y < BOARD_HEIGHT; ++y) {
+    uint8_t code = RENDER_CODE(cellX, y, board[y][cellX]);
+    if (shownCells[y][cellX] == code)
+      continue;
+    const VRAM_PTR_TYPE* map = MapPieceToTileMapForBoardPosition(board[y][cellX], cellX, y);
+    for (uint8_t row = 0; row < GAMEPIECE_HEIGHT; ++row)
+      Vram_SetTile(x, GAMEBOARD_ACTIVE_AREA_TOP + y * GAMEPIECE_HEIGHT + row,
+                   (uint8_t)pgm_read_byte(&map[2 + row * GAMEPIECE_WIDTH + column]));
+    if (column == GAMEPIECE_WIDTH - 1)
+      shownCells[y][cellX] = code; // the whole cell is drawn now
+  }
+}
 
-        if (moveInfo[currentIndex].fellDownHole)
-          moveInfo[currentIndex].xEnd = 2;
-        else
-          moveInfo[currentIndex].xEnd = xEnd - numGreenBlueSeen;
+// Sets up the board for a different level, which Transition_Step then slides in from the right
+static void Transition_Begin(const uint8_t level)
+{
+  SetUpLevel(level);
+  transition.level = level;
+  transition.difficultyStripe = GetDifficultyTileForLevel(level);
+  transition.scroll = 0;
+  transition.column = 0;
+}
 
-        if (currentIndex < MAX_MOVABLE_PIECES - 1)
-          ++currentIndex;
-      }
+// One frame of the slide, call right after the vertical sync. Returns true once the new level is all on screen.
+static bool Transition_Step(void)
+{
+  transition.scroll += TRANSITION_PIXELS_PER_FRAME;
+  Screen.scrollX = transition.scroll;
+  if (transition.scroll % TILE_WIDTH)
+    return false;
+  Transition_DrawColumn(transition.column, transition.level, transition.difficultyStripe);
+  if (++transition.column < VRAM_TILES_H)
+    return false;
+  Vram_Finish();
+
+  shownLevel = transition.level;
+  shownStripe = transition.difficultyStripe;
+  return true;
 }
+#else
+// Without scrolling in the kernel, the new level is drawn in place
+#define Transition_Begin LoadLevel
+#define Transition_Step() true
+#endif
+
+// Directions for TiltBoard, in the same order as the hints
+#define TILT_LEFT 0
+#define TILT_UP 1
+#define TILT_RIGHT 2
+#define TILT_DOWN 3
+
+// How TiltBoard walks the board as lines for the tables in tiltboard.h
+typedef struct {
+  int8_t x;      // where line 0 starts, against the wall being tilted toward
+  int8_t y;
+  int8_t lineDx; // to the start of the next line
+  int8_t lineDy;
+  int8_t cellDx; // to the next cell along a line
+  int8_t cellDy;
+  uint8_t blocks; // cellProperties that stop pieces along this axis
+  uint8_t holeLine;
+  const TILT_LINE_ENDS* lines;
+  const TILT_LINE_ENDS* holeLines;
+} __attribute__ ((packed)) TILT_WALK;
+
+const TILT_WALK tiltWalks[4] PROGMEM = {
+  { 0, 0, 0, 1, 1, 0, CELL_WALL | CELL_BLOCKS_HORIZONTAL, BOARD_HOLE_Y, TILT_ROW_LINES, TILT_LEFT_HOLE_LINES },
+  { 0, 0, 1, 0, 0, 1, CELL_WALL | CELL_BLOCKS_VERTICAL, BOARD_HOLE_X, TILT_COLUMN_LINES, TILT_UP_HOLE_LINES },
+  { BOARD_WIDTH - 1, 0, 0, 1, -1, 0, CELL_WALL | CELL_BLOCKS_HORIZONTAL, BOARD_HOLE_Y, TILT_ROW_LINES, TILT_RIGHT_HOLE_LINES },
+  { 0, BOARD_HEIGHT - 1, 1, 0, 0, -1, CELL_WALL | CELL_BLOCKS_VERTICAL, BOARD_HOLE_X, TILT_COLUMN_LINES, TILT_DOWN_HOLE_LINES },
+};
 
-static void TiltBoardDown() {
-  memset(moveInfo, 0, MAX_MOVABLE_PIECES * sizeof(MOVE_INFO));
+// Each line is looked up as a whole, so the cost of a tilt doesn't depend on how crowded the board is
+static inline __attribute__ ((always_inline)) void TiltLines(const TILT_WALK* walk, const uint8_t lines, const uint8_t cells) {
   uint8_t currentIndex = 0;
+  int8_t lineX = walk->x;
+  int8_t lineY = walk->y;
+
+  for (uint8_t line = 0; line < lines; ++line, lineX += walk->lineDx, lineY += walk->lineDy) {
+    // Base 3, cell 0 in the lowest digit, and both colors of piece slide the same. Anything that blocks
+    // this axis counts as a stopper, including a gate with a piece on it, which then stays where it is.
+    uint16_t index = 0;
+    uint8_t held = 0;
+    for (uint8_t i = cells; i-- > 0;) {
+      uint8_t x = lineX + i * walk->cellDx;
+      uint8_t y = lineY + i * walk->cellDy;
+      held <<= 1;
+      if (cellProperties[y][x] & walk->blocks) {
+        index = index * 3 + 1;
+        held |= 1;
+      } else {
+        index = index * 3 + (board[y][x] ? 2 : 0);
+      }
+    }
 
-  // Start from the bottommost row, and work our way up, looping over each column
-  for (uint8_t y = BOARD_HEIGHT - 1; y != 255; --y)
-    for (uint8_t x = 0; x < BOARD_WIDTH; ++x)
-      if (board[y][x] == G || board[y][x] == B) {
-        moveInfo[currentIndex].piece = board[y][x];
-        moveInfo[currentIndex].xStart = x;
-        moveInfo[currentIndex].yStart = y;
-        moveInfo[currentIndex].xEnd = x;
-
-        // Increment yEnd until we hit a stopper or the edge, subtracting the number of G's and B's along the way
-        uint8_t numGreenBlueSeen = 0;
-        uint8_t yEnd = y;
+    const bool throughHole = (line == walk->holeLine);
+    TILT_LINE_ENDS ends = TILT_LINE_READ(throughHole ? &walk->holeLines[index] : &walk->lines[index]);
 
-        while (yEnd < BOARD_HEIGHT - 1) {
-          uint8_t nextPiece = board[yEnd + 1][x];
+    for (uint8_t i = 0; i < cells; ++i, ends >>= 3, held >>= 1) {
+      uint8_t x = lineX + i * walk->cellDx;
+      uint8_t y = lineY + i * walk->cellDy;
+      uint8_t piece = board[y][x];
+      if (piece != G && piece != B)
+        continue;
 
-          if (nextPiece == S)
-            break;
+      uint8_t end = (held & 1) ? i : (ends & 7);
+      uint8_t xEnd = lineX + end * walk->cellDx;
+      uint8_t yEnd = lineY + end * walk->cellDy;
+      moveInfo[currentIndex].piece = piece;
+      moveInfo[currentIndex].xStart = x;
+      moveInfo[currentIndex].yStart = y;
+      moveInfo[currentIndex].xEnd = xEnd;
+      moveInfo[currentIndex].yEnd = yEnd;
+      if (cellProperties[yEnd][xEnd] & CELL_HOLE) {
+        moveInfo[currentIndex].fellDownHole = true;
+        if (piece == B)
+          youLose = true;
+      }
 
-          if (yEnd + 1 == 2 && x == 2) {
-            moveInfo[currentIndex].fellDownHole = true;
-            if (moveInfo[currentIndex].piece == B)
-              youLose = true;
-            break;
-          }
+      if (currentIndex < MAX_MOVABLE_PIECES - 1)
+        ++currentIndex;
+    }
+  }
+}
 
-          if (nextPiece == G || nextPiece == B)
-            ++numGreenBlueSeen;
+static void TiltBoard(uint8_t direction) {
+  memset(moveInfo, 0, MAX_MOVABLE_PIECES * sizeof(MOVE_INFO));
 
-          ++yEnd;
-        }
+  TILT_WALK walk;
+  memcpy_P(&walk, &tiltWalks[direction], sizeof(walk));
 
-        if (moveInfo[currentIndex].fellDownHole)
-          moveInfo[currentIndex].yEnd = 2;
-        else
-          moveInfo[currentIndex].yEnd = yEnd - numGreenBlueSeen;
+  // Rows and columns can be different lengths, this keeps the loops in TiltLines bounded by constants
+  if (direction == TILT_LEFT || direction == TILT_RIGHT)
+    TiltLines(&walk, BOARD_HEIGHT, BOARD_WIDTH);
+  else
+    TiltLines(&walk, BOARD_WIDTH, BOARD_HEIGHT);
+}
 
-        if (currentIndex < MAX_MOVABLE_PIECES - 1)
-          ++currentIndex;
-      }
+// Whether the tilt TiltBoard just worked out moves any piece at all
+static bool TiltMovedAnything(void)
+{
+  for (uint8_t move = 0; move < MAX_MOVABLE_PIECES; ++move) {
+    if (moveInfo[move].piece == 0)
+      break;
+    if (moveInfo[move].fellDownHole || moveInfo[move].xEnd != moveInfo[move].xStart || moveInfo[move].yEnd != moveInfo[move].yStart)
+      return true;
+  }
+  return false;
 }
 
 static void UpdateBoardAfterMove()
@@ -472,261 +889,954 @@ static void UpdateBoardAfterMove()
   }
   if (!youLose && greenCount == 0)
     youWin = true;
+  if (!youWin && !youLose)
+    search.status = SEARCH_START;
+  else if (search.owner == SEARCH_FOR_STUCK)
+    search.status = SEARCH_IDLE;
 }
 
-#define NEAREST_SCREEN_PIXEL(p)  (((p) + (1 << (FP_SHIFT - 1))) >> FP_SHIFT)
+/*
+ * Hints
+ *
+ * levelhints.h holds one optimal solution per level, 2 bits per tilt. A hint replays it from the
+ * start of the level until it reaches the current board, which costs at most a few dozen bitboard
+ * tilts. Once the player has wandered off that path, a small breadth-first search looks for the
+ * quickest way back onto it (or straight to a win). The search is capped at HINT_SEARCH_TILTS tilts,
+ * the replays that check a board against the path included, so a hint always fits in a frame. If it
+ * comes up empty the hint is to start the level over.
+ */
+#define HINT_NONE 0xFF
+
+#define HINT_BIT(x, y) ((BOARD_BITS)1 << ((y) * BOARD_WIDTH + (x)))
+#define HINT_MASK_BOARD ((BOARD_BITS)BOARD_MASK_ALL)
+#define HINT_MASK_HOLE HINT_BIT(BOARD_HOLE_X, BOARD_HOLE_Y)
+#define HINT_MASK_FIRST_COLUMN ((BOARD_BITS)BOARD_MASK_FIRST_COLUMN)
+#define HINT_MASK_LAST_COLUMN ((BOARD_BITS)BOARD_MASK_LAST_COLUMN)
 
-#define FP_SHIFT                    (2)
-#define WORLD_FPS                   (24)
-#define WORLD_METER                 (10 << FP_SHIFT)
-#define WORLD_GRAVITY               (615)
-#define WORLD_MAX_VELOCITY          (WORLD_METER * 16)
+// Hint directions, in the order tools/solve packs them
+const uint16_t hintButtons[] PROGMEM = { BTN_LEFT, BTN_UP, BTN_RIGHT, BTN_DOWN };
 
-static void UpdatePhysicsLeft()
+static BOARD_BITS Hint_ShiftForward(BOARD_BITS mask, uint8_t direction)
 {
-  for (uint8_t move = 0; move < MAX_MOVABLE_PIECES; ++move) {
-    if (moveInfo[move].piece == 0)
+  switch (direction) {
+  case 0:
+    return (mask >> 1) & ~HINT_MASK_LAST_COLUMN;
+  case 1:
+    return mask >> BOARD_WIDTH;
+  case 2:
+    return (mask << 1) & ~HINT_MASK_FIRST_COLUMN & HINT_MASK_BOARD;
+  default:
+    return (mask << BOARD_WIDTH) & HINT_MASK_BOARD;
+  }
+}
+
+static BOARD_BITS Hint_ShiftBack(BOARD_BITS mask, uint8_t direction)
+{
+  switch (direction) {
+  case 0:
+    return mask << 1;
+  case 1:
+    return mask << BOARD_WIDTH;
+  case 2:
+    return mask >> 1;
+  default:
+    return mask >> BOARD_WIDTH;
+  }
+}
+
+// Same outcome as TiltBoard, but every piece steps at once. Returns false if nothing moved or a blue fell.
+static bool Hint_Tilt(HINT_STATE* s, const BOARD_WALLS* w, uint8_t direction)
+{
+  // A piece sitting on a gate across this axis can't leave it, so it is as good as a wall
+  const BOARD_BITS walls = (direction & 1) ? w->vertical : w->horizontal;
+  bool moved = false;
+  for (;;) {
+    BOARD_BITS pieces = s->greens | s->blues;
+    BOARD_BITS empty = ~(walls | pieces);
+    BOARD_BITS dst = Hint_ShiftForward(pieces & ~walls, direction) & empty;
+    if (!dst)
       break;
+    BOARD_BITS src = Hint_ShiftBack(dst, direction);
+    s->greens = (s->greens & ~src) | Hint_ShiftForward(s->greens & src, direction);
+    s->blues = (s->blues & ~src) | Hint_ShiftForward(s->blues & src, direction);
+    if (s->blues & HINT_MASK_HOLE)
+      return false;
+    s->greens &= ~HINT_MASK_HOLE;
+    moved = true;
+  }
+  return moved;
+}
+
+static void Hint_LoadState(HINT_STATE* s, const uint8_t* cells, bool fromFlash)
+{
+  s->greens = s->blues = 0;
+  for (uint8_t i = 0; i < LEVEL_SIZE; ++i) {
+    uint8_t piece = fromFlash ? (uint8_t)pgm_read_byte(&cells[i]) : cells[i];
+    BOARD_BITS bit = (BOARD_BITS)1 << i;
+    if (piece == G)
+      s->greens |= bit;
+    else if (piece == B)
+      s->blues |= bit;
+  }
+}
+
+// The walls of the level being played, which never change while it is
+static void Hint_LoadWalls(BOARD_WALLS* w)
+{
+  const uint8_t* properties = &cellProperties[0][0];
+  w->horizontal = w->vertical = 0;
+  for (uint8_t i = 0; i < LEVEL_SIZE; ++i) {
+    BOARD_BITS bit = (BOARD_BITS)1 << i;
+    if (properties[i] & (CELL_WALL | CELL_BLOCKS_HORIZONTAL))
+      w->horizontal |= bit;
+    if (properties[i] & (CELL_WALL | CELL_BLOCKS_VERTICAL))
+      w->vertical |= bit;
+  }
+}
+
+static uint8_t Hint_GetMove(uint16_t offset, uint8_t i)
+{
+  return ((uint8_t)pgm_read_byte(&levelHints[offset + (i >> 2)]) >> ((i & 3) * 2)) & 3;
+}
 
-    int16_t ddx = 0;
-    ddx -= WORLD_GRAVITY;
-
-    // Integrate the X forces to calculate the new position (x,y) and the new velocity (dx)
-    moveInfo[move].x += (moveInfo[move].dx / WORLD_FPS);
-    moveInfo[move].dx += (ddx / WORLD_FPS);
-    if (moveInfo[move].dx < -WORLD_MAX_VELOCITY)
-      moveInfo[move].dx = -WORLD_MAX_VELOCITY;
-
-    int16_t xEnd = TILE_WIDTH * (GAMEBOARD_ACTIVE_AREA_LEFT + moveInfo[move].xEnd * GAMEPIECE_WIDTH);
-
-    if (moveInfo[move].x <= (xEnd << FP_SHIFT)) {
-      moveInfo[move].x = xEnd << FP_SHIFT;
-      moveInfo[move].dx = 0;
-      if (!moveInfo[move].doneMoving && moveInfo[move].xStart != moveInfo[move].xEnd) {
-        if (!moveInfo[move].fellDownHole)
-          ++numSlidersHitEndStops;
-        else
-          playFellDownHoleSound = true;
+static inline uint16_t Hint_Fingerprint(const HINT_STATE* s)
+{
+  BOARD_BITS mix = s->greens ^ (s->blues << 7) ^ (s->blues >> 9);
+  return (uint16_t)mix ^ (uint16_t)(mix >> 16);
+}
+
+// Returns the next tilt (0 = LEFT, 1 = UP, 2 = RIGHT, 3 = DOWN) toward solving the current board, or HINT_NONE.
+// It borrows the idle-time search's table (see SCRATCH), so that search starts over on the board once the menu closes.
+static uint8_t GetHint(void)
+{
+  search.status = SEARCH_START;
+
+  HINT_STATE current;
+  BOARD_WALLS walls;
+  Hint_LoadState(&current, &board[0][0], false);
+  Hint_LoadWalls(&walls);
+  if (!current.greens)
+    return HINT_NONE;
+
+  // Endless mode levels have no stored solution, so for them it is the search or nothing
+  uint8_t length = 0;
+  uint16_t offset = 0;
+  if (currentLevel <= NUM_LEVELS) {
+    length = (uint8_t)pgm_read_byte(&levelHintLengths[currentLevel - 1]);
+    offset = (uint16_t)pgm_read_word(&levelHintOffsets[currentLevel - 1]);
+  }
+
+  // Follow the stored solution, remembering a fingerprint of every board along the way
+  HINT_STATE s;
+  if (length)
+    Hint_LoadState(&s, &levelData[(currentLevel - 1) * LEVEL_SIZE + BOARD_OFFSET_IN_LEVEL], true);
+  for (uint8_t i = 0; i < length; ++i) {
+    if (s.greens == current.greens && s.blues == current.blues)
+      return Hint_GetMove(offset, i);
+    scratch.hint.path[i] = Hint_Fingerprint(&s);
+    Hint_Tilt(&s, &walls, Hint_GetMove(offset, i));
+  }
+
+  // Off the path, so search outward from the current board for a win or any board on the path
+  uint8_t head = 0;
+  uint8_t tail = 0;
+  uint16_t tilts = 0;
+  scratch.hint.nodes[tail].state = current;
+  scratch.hint.nodes[tail++].firstMove = HINT_NONE;
+
+  while (head < tail) {
+    HINT_NODE* node = &scratch.hint.nodes[head++];
+    for (uint8_t direction = 0; direction < 4; ++direction) {
+      HINT_STATE next = node->state;
+      if (++tilts > HINT_SEARCH_TILTS)
+        return HINT_NONE;
+      if (!Hint_Tilt(&next, &walls, direction))
+        continue;
+      uint8_t firstMove = (node->firstMove == HINT_NONE) ? direction : node->firstMove;
+      if (!next.greens)
+        return firstMove;
+
+      // A matching fingerprint is checked against the real board on the path before it is trusted
+      uint16_t fingerprint = Hint_Fingerprint(&next);
+      for (uint8_t i = 0; i < length; ++i) {
+        if (scratch.hint.path[i] != fingerprint)
+          continue;
+        tilts += i;
+        if (tilts > HINT_SEARCH_TILTS)
+          return HINT_NONE;
+        Hint_LoadState(&s, &levelData[(currentLevel - 1) * LEVEL_SIZE + BOARD_OFFSET_IN_LEVEL], true);
+        for (uint8_t j = 0; j < i; ++j)
+          Hint_Tilt(&s, &walls, Hint_GetMove(offset, j));
+        if (s.greens == next.greens && s.blues == next.blues)
+          return firstMove;
+      }
+
+      if (tail == HINT_SEARCH_NODES)
+        continue;
+      bool seen = false;
+      for (uint8_t i = 0; i < tail && !seen; ++i)
+        seen = (scratch.hint.nodes[i].state.greens == next.greens && scratch.hint.nodes[i].state.blues == next.blues);
+      if (!seen) {
+        scratch.hint.nodes[tail].state = next;
+        scratch.hint.nodes[tail++].firstMove = firstMove;
       }
-      moveInfo[move].doneMoving = true;
-      if (moveInfo[move].fellDownHole)
-        MapSprite2(move * GAMEPIECE_WIDTH * GAMEPIECE_HEIGHT, moveInfo[move].piece == G ? map_green_h : map_blue_h, 0);
     }
   }
+  return HINT_NONE;
 }
 
-static void UpdatePhysicsUp()
+/*
+ * Idle-time search
+ *
+ * A board is lost when no sequence of tilts wins from it: every way forward drops a blue into the
+ * hole, or the greens can never get to it. Finding that out means visiting every board reachable
+ * from it, which is too much work to do between two frames, so Search_Step expands only a few
+ * boards each frame. Boards are packed so the search table stays small: the 25 bit occupancy of
+ * the greens and blues, then one bit per piece, lowest cell first, set if it is blue. Up to 7
+ * movable pieces fit in 32 bits, boards with more take two words and the table holds half as many.
+ * Being breadth-first, the first win found is also the shortest, which is what endless mode needs
+ * to know about a new level.
+ */
+static SEARCH_KEY Search_Pack(const HINT_STATE* s)
 {
-  for (uint8_t move = 0; move < MAX_MOVABLE_PIECES; ++move) {
-    if (moveInfo[move].piece == 0)
-      break;
+  BOARD_BITS occupied = s->greens | s->blues;
+  SEARCH_KEY packed = occupied;
+  SEARCH_KEY colorBit = (SEARCH_KEY)1 << LEVEL_SIZE;
+  for (BOARD_BITS bit = 1; bit & HINT_MASK_BOARD; bit <<= 1)
+    if (occupied & bit) {
+      if (s->blues & bit)
+        packed |= colorBit;
+      colorBit <<= 1;
+    }
+  return packed;
+}
+
+static void Search_Unpack(HINT_STATE* s, SEARCH_KEY packed)
+{
+  SEARCH_KEY colorBit = (SEARCH_KEY)1 << LEVEL_SIZE;
+  s->greens = s->blues = 0;
+  for (BOARD_BITS bit = 1; bit & HINT_MASK_BOARD; bit <<= 1)
+    if (packed & bit) {
+      if (packed & colorBit)
+        s->blues |= bit;
+      else
+        s->greens |= bit;
+      colorBit <<= 1;
+    }
+}
+
+static SEARCH_KEY Search_GetState(uint8_t i)
+{
+#if LEVEL_SIZE + MAX_MOVABLE_PIECES > 32
+  if (search.wide)
+    return scratch.states[2 * i] | ((SEARCH_KEY)scratch.states[2 * i + 1] << 32);
+#endif
+  return scratch.states[i];
+}
 
-    int16_t ddy = 0;
-    ddy -= WORLD_GRAVITY;
-
-    // Integrate the Y forces to calculate the new position (x,y) and the new velocity (dy)
-    moveInfo[move].y += (moveInfo[move].dy / WORLD_FPS);
-    moveInfo[move].dy += (ddy / WORLD_FPS);
-    if (moveInfo[move].dy < -WORLD_MAX_VELOCITY)
-      moveInfo[move].dy = -WORLD_MAX_VELOCITY;
-
-    int16_t yEnd = TILE_HEIGHT * (GAMEBOARD_ACTIVE_AREA_TOP + moveInfo[move].yEnd * GAMEPIECE_HEIGHT);
-
-    if (moveInfo[move].y <= (yEnd << FP_SHIFT)) {
-      moveInfo[move].y = yEnd << FP_SHIFT;
-      moveInfo[move].dy = 0;
-      if (!moveInfo[move].doneMoving && moveInfo[move].yStart != moveInfo[move].yEnd) {
-        if (!moveInfo[move].fellDownHole)
-          ++numSlidersHitEndStops;
-        else
-          playFellDownHoleSound = true;
+static void Search_SetState(uint8_t i, SEARCH_KEY packed)
+{
+#if LEVEL_SIZE + MAX_MOVABLE_PIECES > 32
+  if (search.wide) {
+    scratch.states[2 * i] = (uint32_t)packed;
+    scratch.states[2 * i + 1] = (uint32_t)(packed >> 32);
+    return;
+  }
+#endif
+  scratch.states[i] = (uint32_t)packed;
+}
+
+static void Search_Begin(const HINT_STATE* start, const BOARD_WALLS* walls, uint8_t owner)
+{
+  // Pieces only ever leave the board, so the start decides how wide every board in this search is
+  uint8_t bits = LEVEL_SIZE;
+  for (BOARD_BITS pieces = start->greens | start->blues; pieces; pieces &= pieces - 1)
+    ++bits;
+  search.wide = (bits > 32);
+  search.capacity = search.wide ? SEARCH_WORDS / 2 : SEARCH_WORDS;
+
+  search.owner = owner;
+  search.walls = *walls;
+  Search_SetState(0, Search_Pack(start));
+  search.head = 0;
+  search.tail = 1;
+  search.layerEnd = 1;
+  search.depth = 0;
+  search.status = SEARCH_RUNNING;
+}
+
+// Each expanded board costs an unpack, 4 tilts, up to 4 packs and a scan of the table, a few thousand cycles at most
+static void Search_Step(uint8_t nodes)
+{
+  if (search.status == SEARCH_START) {
+    HINT_STATE current;
+    BOARD_WALLS walls;
+    Hint_LoadState(&current, &board[0][0], false);
+    Hint_LoadWalls(&walls);
+    Search_Begin(&current, &walls, SEARCH_FOR_STUCK);
+    return;
+  }
+
+  for (uint8_t n = 0; n < nodes && search.status == SEARCH_RUNNING; ++n) {
+    if (search.head == search.tail) {
+      search.status = SEARCH_LOST;
+      return;
+    }
+    if (search.head == search.layerEnd) {
+      ++search.depth;
+      search.layerEnd = search.tail;
+    }
+
+    HINT_STATE s;
+    Search_Unpack(&s, Search_GetState(search.head++));
+    for (uint8_t direction = 0; direction < 4; ++direction) {
+      HINT_STATE next = s;
+      if (!Hint_Tilt(&next, &search.walls, direction))
+        continue;
+      if (!next.greens) {
+        ++search.depth;
+        search.status = SEARCH_WINNABLE;
+        return;
       }
-      moveInfo[move].doneMoving = true;
-      if (moveInfo[move].fellDownHole)
-        MapSprite2(move * GAMEPIECE_WIDTH * GAMEPIECE_HEIGHT, moveInfo[move].piece == G ? map_green_h : map_blue_h, 0);
+
+      SEARCH_KEY packed = Search_Pack(&next);
+      bool seen = false;
+      for (uint8_t i = 0; i < search.tail && !seen; ++i)
+        seen = (Search_GetState(i) == packed);
+      if (seen)
+        continue;
+      if (search.tail == search.capacity) {
+        search.status = SEARCH_GAVE_UP;
+        return;
+      }
+      Search_SetState(search.tail++, packed);
+    }
+  }
+}
+
+/*
+ * Endless mode
+ *
+ * After the last level in levels.h, new levels are made up on the spot. Candidates come from a
+ * seeded random number generator, so the sequence is the same every time, and one is only kept
+ * once the idle-time search has solved it and found it takes at least ENDLESS_MIN_MOVES tilts.
+ * Candidates that are too big for the search table are thrown away. Work starts with the first
+ * built-in level, so one accepted level is normally in reserve long before levels.h runs out, and
+ * the next one is worked on while that one is played. If PASS is confirmed with nothing in reserve,
+ * WAIT is shown while the search gets the whole frame, and after ENDLESS_MAX_WAIT frames a built-in
+ * level turned by a symmetry of the board is played instead, so the wait is always bounded.
+ */
+static uint8_t Endless_Random(uint8_t range)
+{
+  // xorshift, period 2^16 - 1
+  endless.random ^= endless.random << 7;
+  endless.random ^= endless.random >> 9;
+  endless.random ^= endless.random << 8;
+  return (uint8_t)(endless.random % range);
+}
+
+// Drops 'count' pieces on random empty cells, never on the hole
+static BOARD_BITS Endless_Scatter(BOARD_BITS* taken, uint8_t count)
+{
+  BOARD_BITS placed = 0;
+  while (count) {
+    BOARD_BITS bit = (BOARD_BITS)1 << Endless_Random(LEVEL_SIZE);
+    if ((*taken | HINT_MASK_HOLE) & bit)
+      continue;
+    *taken |= bit;
+    placed |= bit;
+    --count;
+  }
+  return placed;
+}
+
+static void Endless_MakeCandidate(void)
+{
+  BOARD_BITS taken = 0;
+  uint8_t greens = 1 + Endless_Random(3);
+  uint8_t blues = Endless_Random(ENDLESS_MAX_PIECES - greens + 1);
+  endless.stoppers = Endless_Scatter(&taken, 2 + Endless_Random(4));
+  endless.greens = Endless_Scatter(&taken, greens);
+  endless.blues = Endless_Scatter(&taken, blues);
+}
+
+// Moves the next endless mode level along, call once per frame whenever the search may be free
+static void Endless_Step(void)
+{
+  if (endless.ready || search.status == SEARCH_START)
+    return;
+  // The board being played comes first, and a lost one stays that way so STUCK can be shown
+  if (search.owner == SEARCH_FOR_STUCK && (search.status <= SEARCH_RUNNING || search.status == SEARCH_LOST))
+    return;
+
+  if (endless.pending && search.owner == SEARCH_FOR_ENDLESS) {
+    if (search.status == SEARCH_RUNNING)
+      return;
+    endless.pending = false;
+    if (search.status == SEARCH_WINNABLE && search.depth >= ENDLESS_MIN_MOVES) {
+      endless.moves = search.depth;
+      endless.ready = true;
+      return;
+    }
+  }
+
+  // Start on a new candidate, or start over on one whose search was taken over by a board change
+  if (!endless.pending)
+    Endless_MakeCandidate();
+  // Endless mode levels only have stoppers, no gates
+  HINT_STATE start = { endless.greens, endless.blues };
+  BOARD_WALLS walls = { endless.stoppers, endless.stoppers };
+  Search_Begin(&start, &walls, SEARCH_FOR_ENDLESS);
+  endless.pending = true;
+}
+
+static void Endless_SetBand(void)
+{
+  endless.band = 0;
+  while (endless.band < sizeof(levelBandMaxLengths) && endless.moves > pgm_read_byte(&levelBandMaxLengths[endless.band]))
+    ++endless.band;
+}
+
+static uint8_t Endless_LevelAfter(uint8_t level)
+{
+  return (level >= NUM_LEVELS && level < ENDLESS_LAST_LEVEL) ? level + 1 : NUM_LEVELS + 1;
+}
+
+// Makes the accepted level the one being played, only once endless.ready (see Result_Tick)
+static uint8_t Endless_NextLevel(uint8_t level)
+{
+  for (uint8_t i = 0; i < LEVEL_SIZE; ++i) {
+    BOARD_BITS bit = (BOARD_BITS)1 << i;
+    endless.cells[i] = (endless.stoppers & bit) ? S : (endless.greens & bit) ? G : (endless.blues & bit) ? B : 0;
+  }
+  Endless_SetBand();
+  endless.ready = false;
+  return Endless_LevelAfter(level);
+}
+
+// Plays a random built-in level, mirrored and/or transposed, when the search is too slow to find
+// the next one. levels.h is validated, so it is known to be solvable, and in the same number of tilts.
+// The candidate being searched is left alone and becomes the level after this one.
+static uint8_t Endless_Fallback(uint8_t level)
+{
+  const uint8_t source = Endless_Random(NUM_LEVELS);
+  const uint8_t symmetry = Endless_Random(8);
+  const bool transpose = ENDLESS_TRANSPOSE && (symmetry & 1);
+  for (uint8_t y = 0; y < BOARD_HEIGHT; ++y)
+    for (uint8_t x = 0; x < BOARD_WIDTH; ++x) {
+      uint8_t sx = transpose ? y : x;
+      uint8_t sy = transpose ? x : y;
+      if (ENDLESS_MIRROR_X && (symmetry & 2))
+        sx = BOARD_WIDTH - 1 - sx;
+      if (ENDLESS_MIRROR_Y && (symmetry & 4))
+        sy = BOARD_HEIGHT - 1 - sy;
+      uint8_t piece = (uint8_t)pgm_read_byte(&levelData[source * LEVEL_SIZE + BOARD_OFFSET_IN_LEVEL + sy * BOARD_WIDTH + sx]);
+      if (transpose && (piece == H || piece == V))
+        piece = (piece == H) ? V : H;
+      endless.cells[y * BOARD_WIDTH + x] = piece;
+    }
+  // The reserve is empty here, so endless.moves is free until the search accepts a candidate
+  endless.moves = (uint8_t)pgm_read_byte(&levelHintLengths[source]);
+  Endless_SetBand();
+  return Endless_LevelAfter(level);
+}
+
+/*
+ * Input
+ *
+ * Input_Sample runs in the vertical sync interrupt every frame, right after the kernel reads the
+ * controllers, and queues an event whenever a button goes down. Letting go only updates what is held,
+ * since nothing acts on it. A button pressed and let go while the game is busy (an animation, a level
+ * sliding in) is never missed, it just comes out of Input_Read a little later. The interrupt also ages
+ * every waiting event by a frame, stopping just past INPUT_MAX_AGE so the count can't wrap around, and
+ * events older than INPUT_MAX_AGE are dropped rather than acted on.
+ */
+#define INPUT_QUEUE_LENGTH 8 // a power of 2
+#define INPUT_MAX_AGE 60
+
+// Keeps the compiler from moving reads or writes of an event across the head or tail update that hands it over
+#define INPUT_BARRIER() __asm__ __volatile__ ("" ::: "memory")
+
+typedef struct {
+  uint16_t held;
+  uint16_t pressed;
+  volatile uint8_t age; // frames it has been waiting, up to INPUT_MAX_AGE + 1
+} __attribute__ ((packed)) INPUT_EVENT;
+
+typedef struct {
+  INPUT_EVENT events[INPUT_QUEUE_LENGTH];
+  volatile uint8_t head; // only Input_Read moves it
+  volatile uint8_t tail; // only Input_Sample moves it
+  uint16_t held;         // as of the last sample, two bytes the interrupt can land between (see Input_Read)
+} INPUT_QUEUE;
+
+INPUT_QUEUE inputQueue;
+
+static bool Input_Fresh(const INPUT_EVENT* e)
+{
+  return e->age <= INPUT_MAX_AGE;
+}
+
+static void Input_Sample(void)
+{
+  uint8_t tail = inputQueue.tail;
+  for (uint8_t i = inputQueue.head; i != tail; i = (i + 1) & (INPUT_QUEUE_LENGTH - 1))
+    if (Input_Fresh(&inputQueue.events[i]))
+      ++inputQueue.events[i].age;
+
+  uint16_t held = ReadJoypad(0);
+  uint16_t pressed = held & ~inputQueue.held;
+  inputQueue.held = held;
+  if (!pressed)
+    return;
+
+  uint8_t next = (tail + 1) & (INPUT_QUEUE_LENGTH - 1);
+  if (next == inputQueue.head)
+    return; // nobody is reading, so this one goes
+  INPUT_EVENT* e = &inputQueue.events[tail];
+  e->held = held;
+  e->pressed = pressed;
+  e->age = 0;
+  INPUT_BARRIER();
+  inputQueue.tail = next;
+}
+
+static void Input_Init(void)
+{
+  SetUserPostVsyncCallback(&Input_Sample);
+}
+
+// Takes the next fresh press off the queue, or just what is held right now if nothing has been pressed.
+// Stale presses are thrown away on the way.
+static void Input_Read(BUTTON_INFO* buttons)
+{
+  buttons->pressed = 0;
+  while (inputQueue.head != inputQueue.tail) {
+    INPUT_BARRIER();
+    INPUT_EVENT* e = &inputQueue.events[inputQueue.head];
+    bool fresh = Input_Fresh(e);
+    if (fresh) {
+      buttons->held = e->held;
+      buttons->pressed = e->pressed;
     }
+    INPUT_BARRIER(); // the slot can be reused as soon as head moves past it
+    inputQueue.head = (inputQueue.head + 1) & (INPUT_QUEUE_LENGTH - 1);
+    if (fresh)
+      return;
+  }
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    buttons->held = inputQueue.held;
+  }
+}
+
+// Whether a fresh event that tilts the board is waiting, without taking anything off the queue
+static bool Input_TiltWaiting(void)
+{
+  for (uint8_t i = inputQueue.head; i != inputQueue.tail; i = (i + 1) & (INPUT_QUEUE_LENGTH - 1)) {
+    INPUT_BARRIER();
+    const INPUT_EVENT* e = &inputQueue.events[i];
+    if (!Input_Fresh(e))
+      continue;
+    if (e->pressed == BTN_LEFT || e->pressed == BTN_UP || e->pressed == BTN_RIGHT || e->pressed == BTN_DOWN)
+      return true;
   }
+  return false;
 }
 
-static void UpdatePhysicsRight()
+// START or A on its own
+static bool Input_Confirmed(const BUTTON_INFO* buttons)
+{
+  return (buttons->pressed & BTN_START && buttons->held == BTN_START) ||
+         (buttons->pressed & BTN_A && buttons->held == BTN_A);
+}
+
+#if GAMEPIECE_WIDTH * TILE_WIDTH != SLIDE_CELL_PIXELS || GAMEPIECE_HEIGHT * TILE_HEIGHT != SLIDE_CELL_PIXELS
+#error tools/slide.c has to know how many pixels a cell is
+#endif
+
+// How many cells a piece slides, which is all its slide depends on (see tools/slide.c)
+static uint8_t SlideCells(const MOVE_INFO* m)
+{
+  return (uint8_t)abs((int8_t)(m->xEnd - m->xStart)) + (uint8_t)abs((int8_t)(m->yEnd - m->yStart));
+}
+
+// Where a piece is on the screen, in pixels, m->frame frames into its slide
+static void SlidePosition(const MOVE_INFO* m, uint8_t* x, uint8_t* y)
+{
+  uint8_t slid = (m->frame >= m->landingFrame) ? SlideCells(m) * SLIDE_CELL_PIXELS : pgm_read_byte(&slidePixels[m->frame]);
+  *x = TILE_WIDTH * (GAMEBOARD_ACTIVE_AREA_LEFT + m->xStart * GAMEPIECE_WIDTH);
+  *y = TILE_HEIGHT * (GAMEBOARD_ACTIVE_AREA_TOP + m->yStart * GAMEPIECE_HEIGHT);
+  if (m->xEnd < m->xStart)
+    *x -= slid;
+  else if (m->xEnd > m->xStart)
+    *x += slid;
+  else if (m->yEnd < m->yStart)
+    *y -= slid;
+  else
+    *y += slid;
+}
+
+// Moves every piece that has started one frame further along its slide, and counts the ones landing.
+// With snap every piece still moving or waiting to start lands right away instead.
+static void UpdatePhysics(bool snap)
 {
   for (uint8_t move = 0; move < MAX_MOVABLE_PIECES; ++move) {
     if (moveInfo[move].piece == 0)
       break;
-
-    int16_t ddx = 0;
-    ddx += WORLD_GRAVITY;
-
-    // Integrate the X forces to calculate the new position (x,y) and the new velocity (dx)
-    moveInfo[move].x += (moveInfo[move].dx / WORLD_FPS);
-    moveInfo[move].dx += (ddx / WORLD_FPS);
-    if (moveInfo[move].dx > WORLD_MAX_VELOCITY)
-      moveInfo[move].dx = WORLD_MAX_VELOCITY;
-
-    int16_t xEnd = TILE_WIDTH * (GAMEBOARD_ACTIVE_AREA_LEFT + moveInfo[move].xEnd * GAMEPIECE_WIDTH);
-
-    if (moveInfo[move].x >= (xEnd << FP_SHIFT)) {
-      moveInfo[move].x = xEnd << FP_SHIFT;
-      moveInfo[move].dx = 0;
-      if (!moveInfo[move].doneMoving && moveInfo[move].xStart != moveInfo[move].xEnd) {
-        if (!moveInfo[move].fellDownHole)
-          ++numSlidersHitEndStops;
-        else
-          playFellDownHoleSound = true;
-      }
-      moveInfo[move].doneMoving = true;
-      if (moveInfo[move].fellDownHole)
-        MapSprite2(move * GAMEPIECE_WIDTH * GAMEPIECE_HEIGHT, moveInfo[move].piece == G ? map_green_h : map_blue_h, 0);
+    if (moveInfo[move].doneMoving || (moveInfo[move].sprite == MOVE_WAITING && !snap))
+      continue;
+
+    if (snap)
+      moveInfo[move].frame = moveInfo[move].landingFrame;
+    else if (++moveInfo[move].frame < moveInfo[move].landingFrame)
+      continue;
+    moveInfo[move].doneMoving = true;
+    if (moveInfo[move].landingFrame) {
+      if (!moveInfo[move].fellDownHole)
+        ++numSlidersHitEndStops;
+      else
+        playFellDownHoleSound = true;
     }
   }
 }
 
-static void UpdatePhysicsDown()
+// Puts back the part of the board under one screen tile of the gameboard's active area
+static void RestoreGridTile(uint8_t tileX, uint8_t tileY)
+{
+  uint8_t x = tileX - GAMEBOARD_ACTIVE_AREA_LEFT;
+  uint8_t y = tileY - GAMEBOARD_ACTIVE_AREA_TOP;
+  const VRAM_PTR_TYPE* map = MapBoardPositionToGridTileMap(x / GAMEPIECE_WIDTH, y / GAMEPIECE_HEIGHT);
+  Vram_SetTile(tileX, tileY, (uint8_t)pgm_read_byte(&map[2 + (y % GAMEPIECE_HEIGHT) * GAMEPIECE_WIDTH + x % GAMEPIECE_WIDTH]));
+}
+
+// Moves a piece that didn't get any sprites by drawing it at the nearest whole tile, which costs no ram tiles
+static void MovePieceTiles(MOVE_INFO* m)
+{
+  uint8_t x, y;
+  SlidePosition(m, &x, &y);
+  uint8_t tileX = (x + TILE_WIDTH / 2) / TILE_WIDTH;
+  uint8_t tileY = (y + TILE_HEIGHT / 2) / TILE_HEIGHT;
+  if (tileX == m->tileX && tileY == m->tileY)
+    return;
+
+  // Only the tiles it is leaving go back to the board, so nothing under the piece flickers
+  for (uint8_t y = 0; y < GAMEPIECE_HEIGHT; ++y)
+    for (uint8_t x = 0; x < GAMEPIECE_WIDTH; ++x)
+      if ((uint8_t)(m->tileX + x - tileX) >= GAMEPIECE_WIDTH || (uint8_t)(m->tileY + y - tileY) >= GAMEPIECE_HEIGHT)
+        RestoreGridTile(m->tileX + x, m->tileY + y);
+
+  Vram_DrawMap(tileX, tileY, m->piece == G ? map_green : map_blue);
+  m->tileX = tileX;
+  m->tileY = tileY;
+}
+
+/*
+ * Ram tile budget
+ *
+ * Mode 3 draws sprites by blitting them into ram tiles, one for each background tile a sprite
+ * overlaps. A piece between two cells needs 6 of them, and pieces touching along the line they move
+ * on share the column between them. Sprites get whatever ram tiles the game isn't using, and past
+ * that they silently drop out. RamTiles_Measure counts what the sprites on screen need every frame,
+ * and GravityAnimation only starts a line of pieces once its worst case fits.
+ */
+typedef struct {
+  uint8_t frame;     // ram tiles the sprites needed this frame
+  uint8_t animation; // the most in any frame of the last animation
+  uint8_t highWater; // the most ever (kept in EEPROM when built with DEBUG_RAM_TILES)
+} __attribute__ ((packed)) RAM_TILE_STATS;
+
+RAM_TILE_STATS ramTileStats;
+
+#if DEBUG_RAM_TILES
+#define EEPROM_ID_RAM_TILES 0x5452 // debug builds only, so not in the Uzebox EEPROM id list
+
+RAM_TILE_STATS ramTileStatsShown; // what RamTiles_DrawStats last queued
+bool ramTileHighWaterUnsaved;     // a new record that Task_SaveRamTiles hasn't written to EEPROM yet
+
+static void RamTiles_LoadHighWater(void)
+{
+  struct EepromBlockStruct block;
+  if (isEepromFormatted() && EepromReadBlock(EEPROM_ID_RAM_TILES, &block) == 0)
+    ramTileStats.highWater = block.data[0];
+  memset(&ramTileStatsShown, 0xFF, sizeof(ramTileStatsShown)); // the screen was just cleared
+}
+
+// Blocks for a few frames while the EEPROM is written, so it only runs from the tasks table (see Task_SaveRamTiles)
+static void RamTiles_SaveHighWater(void)
+{
+  struct EepromBlockStruct block;
+  memset(&block, 0, sizeof(block));
+  block.id = EEPROM_ID_RAM_TILES;
+  block.data[0] = ramTileStats.highWater;
+  EepromWriteBlock(&block);
+}
+
+// Two digits each in the top left corner: this frame, the last animation, the most ever. Only the ones
+// that changed are queued, so the vram queue has room for the animation.
+static void RamTiles_DrawStats(void)
+{
+  const uint8_t* stats = &ramTileStats.frame;
+  uint8_t* shown = &ramTileStatsShown.frame;
+  for (uint8_t i = 0; i < sizeof(RAM_TILE_STATS); ++i) {
+    if (shown[i] == stats[i])
+      continue;
+    shown[i] = stats[i];
+    uint8_t digits[2] = {0};
+    BCD_addConstant(digits, 2, stats[i]);
+    Vram_SetTile(i * 3, 0, TILE_NUM_START_DIGITS + digits[1]);
+    Vram_SetTile(i * 3 + 1, 0, TILE_NUM_START_DIGITS + digits[0]);
+  }
+}
+#endif
+
+// What the blitter needs for the sprites on screen right now
+static uint8_t RamTiles_Measure(void)
 {
+  uint16_t covered[BOARD_HEIGHT * GAMEPIECE_HEIGHT]; // one bit per screen tile of the active area
+  memset(covered, 0, sizeof(covered));
   for (uint8_t move = 0; move < MAX_MOVABLE_PIECES; ++move) {
     if (moveInfo[move].piece == 0)
       break;
+    if (moveInfo[move].sprite >= MOVE_SETTLED)
+      continue;
+
+    uint8_t x, y;
+    SlidePosition(&moveInfo[move], &x, &y);
+    x -= TILE_WIDTH * GAMEBOARD_ACTIVE_AREA_LEFT;
+    y -= TILE_HEIGHT * GAMEBOARD_ACTIVE_AREA_TOP;
+    uint8_t left = x / TILE_WIDTH;
+    uint8_t right = (x + GAMEPIECE_WIDTH * TILE_WIDTH - 1) / TILE_WIDTH;
+    uint16_t columns = (uint16_t)((2U << right) - (1U << left));
+    for (uint8_t row = y / TILE_HEIGHT; row <= (y + GAMEPIECE_HEIGHT * TILE_HEIGHT - 1) / TILE_HEIGHT; ++row)
+      covered[row] |= columns;
+  }
 
-    int16_t ddy = 0;
-    ddy += WORLD_GRAVITY;
-
-    // Integrate the Y forces to calculate the new position (x,y) and the new velocity (dy)
-    moveInfo[move].y += (moveInfo[move].dy / WORLD_FPS);
-    moveInfo[move].dy += (ddy / WORLD_FPS);
-    if (moveInfo[move].dy > WORLD_MAX_VELOCITY)
-      moveInfo[move].dy = WORLD_MAX_VELOCITY;
-
-    int16_t yEnd = TILE_HEIGHT * (GAMEBOARD_ACTIVE_AREA_TOP + moveInfo[move].yEnd * GAMEPIECE_HEIGHT);
-
-    if (moveInfo[move].y >= (yEnd << FP_SHIFT)) {
-      moveInfo[move].y = yEnd << FP_SHIFT;
-      moveInfo[move].dy = 0;
-      if (!moveInfo[move].doneMoving && moveInfo[move].yStart != moveInfo[move].yEnd) {
-        if (!moveInfo[move].fellDownHole)
-          ++numSlidersHitEndStops;
-        else
-          playFellDownHoleSound = true;
-      }
-      moveInfo[move].doneMoving = true;
-      if (moveInfo[move].fellDownHole)
-        MapSprite2(move * GAMEPIECE_WIDTH * GAMEPIECE_HEIGHT, moveInfo[move].piece == G ? map_green_h : map_blue_h, 0);
+  uint8_t count = 0;
+  for (uint8_t row = 0; row < BOARD_HEIGHT * GAMEPIECE_HEIGHT; ++row)
+    for (uint16_t columns = covered[row]; columns; columns &= columns - 1)
+      ++count;
+  return count;
+}
+
+// The most ram tiles the moving pieces in moveInfo[first ... end-1] (one line) can need in any frame
+static uint8_t RamTiles_LinePeak(uint8_t first, uint8_t end, bool horizontal)
+{
+  const uint8_t along = horizontal ? GAMEPIECE_WIDTH : GAMEPIECE_HEIGHT;
+  const uint8_t across = horizontal ? GAMEPIECE_HEIGHT : GAMEPIECE_WIDTH;
+  uint8_t columns = 0;
+  uint8_t prevCell = 0xF0; // nowhere near any cell
+  for (uint8_t move = first; move < end; ++move) {
+    if (moveInfo[move].sprite != MOVE_WAITING) {
+      prevCell = 0xF0;
+      continue;
     }
+    // Touching pieces move in step until the front one stops, so a run of them only needs one extra column
+    uint8_t cell = horizontal ? moveInfo[move].xStart : moveInfo[move].yStart;
+    columns += along;
+    if (cell != (uint8_t)(prevCell + 1) && (uint8_t)(cell + 1) != prevCell)
+      ++columns;
+    prevCell = cell;
   }
+  return columns * across;
 }
 
-static void UpdatePhysics(uint8_t direction)
+static uint8_t FindFreeSprite(void)
 {
-  if (direction == BTN_LEFT)
-    UpdatePhysicsLeft();
-  else if (direction == BTN_UP)
-    UpdatePhysicsUp();
-  else if (direction == BTN_RIGHT)
-    UpdatePhysicsRight();
-  else if (direction == BTN_DOWN)
-    UpdatePhysicsDown();
+  for (uint8_t sprite = 0;; sprite += GAMEPIECE_WIDTH * GAMEPIECE_HEIGHT) {
+    bool used = false;
+    for (uint8_t move = 0; move < MAX_MOVABLE_PIECES && moveInfo[move].piece != 0 && !used; ++move)
+      used = (moveInfo[move].sprite == sprite);
+    if (!used)
+      return sprite;
+  }
+}
+
+// Starts every waiting line whose worst case fits in the ram tiles (and sprites) the running lines leave over,
+// so a smaller line may go ahead of a bigger one. A line that could never fit moves with tiles instead.
+static void StartWaitingLines(bool horizontal, uint8_t* reserved, uint8_t* linePeaks)
+{
+  uint8_t numSpritePieces = 0;
+  for (uint8_t move = 0; move < MAX_MOVABLE_PIECES && moveInfo[move].piece != 0; ++move)
+    if (moveInfo[move].sprite < MOVE_SETTLED)
+      ++numSpritePieces;
+
+  for (uint8_t move = 0; move < MAX_MOVABLE_PIECES && moveInfo[move].piece != 0;) {
+    uint8_t line = horizontal ? moveInfo[move].yStart : moveInfo[move].xStart;
+    uint8_t lineEnd = move;
+    uint8_t numWaiting = 0;
+    for (; lineEnd < MAX_MOVABLE_PIECES && moveInfo[lineEnd].piece != 0; ++lineEnd) {
+      if ((horizontal ? moveInfo[lineEnd].yStart : moveInfo[lineEnd].xStart) != line)
+        break;
+      if (moveInfo[lineEnd].sprite == MOVE_WAITING)
+        ++numWaiting;
+    }
+    if (!numWaiting) {
+      move = lineEnd;
+      continue;
+    }
+
+    uint8_t peak = RamTiles_LinePeak(move, lineEnd, horizontal);
+    bool never = (peak > SPRITE_RAM_TILES || numWaiting > SPRITE_PIECES);
+    if (!never && (*reserved + peak > SPRITE_RAM_TILES || numSpritePieces + numWaiting > SPRITE_PIECES)) {
+      move = lineEnd;
+      continue;
+    }
+    if (!never) {
+      *reserved += peak;
+      linePeaks[line] = peak;
+      numSpritePieces += numWaiting;
+    }
+
+    // Turn the pieces into sprites, and draw a blank grid where they were
+    for (; move < lineEnd; ++move) {
+      if (moveInfo[move].sprite != MOVE_WAITING)
+        continue;
+      if (never) {
+        // MovePieceTiles puts the grid back under it as it leaves
+        moveInfo[move].sprite = MOVE_TILES;
+        shownCells[moveInfo[move].yStart][moveInfo[move].xStart] = RENDER_CODE(moveInfo[move].xStart, moveInfo[move].yStart, 0);
+        continue;
+      }
+      moveInfo[move].sprite = FindFreeSprite();
+      MapSprite2(moveInfo[move].sprite, moveInfo[move].piece == G ? map_green : map_blue, 0);
+      MoveSprite(moveInfo[move].sprite,
+                 TILE_WIDTH * moveInfo[move].tileX,
+                 TILE_HEIGHT * moveInfo[move].tileY,
+                 GAMEPIECE_WIDTH, GAMEPIECE_HEIGHT);
+
+      Render_Cell(moveInfo[move].xStart, moveInfo[move].yStart, 0);
+    }
+  }
 }
 
 static void GravityAnimation(uint8_t direction)
 {
-  // Initialize the starting positions and velocities with sub-pixel precision
+  const bool horizontal = (direction == BTN_LEFT || direction == BTN_RIGHT);
+
+  // Every slide starts from rest, so when each piece lands is known before anything moves
   for (uint8_t move = 0; move < MAX_MOVABLE_PIECES; ++move) {
     if (moveInfo[move].piece == 0)
       break;
 
-    int16_t xStart = TILE_WIDTH * (GAMEBOARD_ACTIVE_AREA_LEFT + moveInfo[move].xStart * GAMEPIECE_WIDTH);
-    int16_t yStart = TILE_HEIGHT * (GAMEBOARD_ACTIVE_AREA_TOP + moveInfo[move].yStart * GAMEPIECE_HEIGHT);
-
-    moveInfo[move].x = xStart << FP_SHIFT;
-    moveInfo[move].y = yStart << FP_SHIFT;
-    moveInfo[move].dx = moveInfo[move].dy = 0;
+    moveInfo[move].tileX = GAMEBOARD_ACTIVE_AREA_LEFT + moveInfo[move].xStart * GAMEPIECE_WIDTH;
+    moveInfo[move].tileY = GAMEBOARD_ACTIVE_AREA_TOP + moveInfo[move].yStart * GAMEPIECE_HEIGHT;
+    moveInfo[move].frame = 0;
+    moveInfo[move].landingFrame = pgm_read_byte(&slideLandingFrame[SlideCells(&moveInfo[move])]);
     moveInfo[move].doneMoving = false;
+    // Pieces that stay put are already drawn where they end up
+    bool moves = (moveInfo[move].xStart != moveInfo[move].xEnd || moveInfo[move].yStart != moveInfo[move].yEnd);
+    moveInfo[move].sprite = moves ? MOVE_WAITING : MOVE_SETTLED;
   }
 
+  // Ram tiles set aside for each running line, given back once all of its pieces have settled
+  uint8_t linePeaks[BOARD_WIDTH > BOARD_HEIGHT ? BOARD_WIDTH : BOARD_HEIGHT] = {0};
+  uint8_t reserved = 0;
+  StartWaitingLines(horizontal, &reserved, linePeaks);
+  ramTileStats.animation = 0;
+  bool blueInHole = false;
+
   bool allDoneMoving;
   do {
     allDoneMoving = true;
     numSlidersHitEndStops = 0;
     playFellDownHoleSound = false;
 
-    UpdatePhysics(direction);
+    // Another tilt waiting (or the INSTANT setting) lands everything now, with the sounds of all those landings
+    bool snap = instantTilts || Input_TiltWaiting();
+    if (snap)
+      for (uint8_t move = 0; move < MAX_MOVABLE_PIECES && moveInfo[move].piece != 0; ++move)
+        if (moveInfo[move].sprite == MOVE_WAITING)
+          Render_Cell(moveInfo[move].xStart, moveInfo[move].yStart, 0); // never left the tiles it started on
+
+    UpdatePhysics(snap);
+    if (numSlidersHitEndStops > SFX_LOUDEST_SLIDERS)
+      numSlidersHitEndStops = SFX_LOUDEST_SLIDERS;
     if (numSlidersHitEndStops > 0)
       TriggerNote(SFX_CHANNEL, SFX_SLIDER_STOP, SFX_SPEED_SLIDER_STOP, SFX_VOL_SLIDER_STOP + 24 * numSlidersHitEndStops);
 
     if (playFellDownHoleSound)
-      TriggerNote(SFX_CHANNEL, SFX_SLIDER_HOLE, SFX_SPEED_SLIDER_HOLE, SFX_VOL_SLIDER_HOLE + 24 * MAX_MOVABLE_PIECES);
+      TriggerNote(SFX_CHANNEL, SFX_SLIDER_HOLE, SFX_SPEED_SLIDER_HOLE, SFX_VOL_SLIDER_HOLE + 24 * SFX_LOUDEST_SLIDERS);
 
     for (uint8_t move = 0; move < MAX_MOVABLE_PIECES; ++move) {
       if (moveInfo[move].piece == 0)
         break;
 
-        MoveSprite(move * GAMEPIECE_WIDTH * GAMEPIECE_HEIGHT,
-                   NEAREST_SCREEN_PIXEL(moveInfo[move].x),
-                   NEAREST_SCREEN_PIXEL(moveInfo[move].y),
-                   GAMEPIECE_WIDTH, GAMEPIECE_HEIGHT);
+        if (moveInfo[move].sprite < MOVE_SETTLED) {
+          uint8_t x, y;
+          SlidePosition(&moveInfo[move], &x, &y);
+          MoveSprite(moveInfo[move].sprite, x, y, GAMEPIECE_WIDTH, GAMEPIECE_HEIGHT);
+        } else if (moveInfo[move].sprite == MOVE_TILES)
+          MovePieceTiles(&moveInfo[move]);
+
+        // Back to tiles as soon as it stops, which frees its sprites and ram tiles for the lines still waiting
+        if (moveInfo[move].doneMoving && moveInfo[move].sprite != MOVE_SETTLED) {
+          if (moveInfo[move].sprite < MOVE_SETTLED)
+            for (uint8_t i = 0; i < GAMEPIECE_WIDTH * GAMEPIECE_HEIGHT; ++i)
+              sprites[moveInfo[move].sprite + i].y = SCREEN_TILES_V * TILE_HEIGHT; // OFF_SCREEN;
+          else // drawn over tile by tile, without the shape of the cell it ends on
+            shownCells[moveInfo[move].yEnd][moveInfo[move].xEnd] = RENDER_UNKNOWN;
+          moveInfo[move].sprite = MOVE_SETTLED;
+          // A blue that fell in the hole stays on top of any green that falls in after it
+          blueInHole |= (moveInfo[move].fellDownHole && moveInfo[move].piece == B);
+          Render_Cell(moveInfo[move].xEnd, moveInfo[move].yEnd,
+                      (moveInfo[move].fellDownHole && blueInHole) ? B : moveInfo[move].piece);
+        }
 
         allDoneMoving &= moveInfo[move].doneMoving;
     }
 
-    WaitVsync(1);
-  } while (!allDoneMoving);
-}
-
-// This function expects moveInfo to be populated before calling
-static void AnimateBoard(uint8_t direction)
-{
-  // Hide all sprites
-  for (uint8_t i = 0; i < MAX_SPRITES; ++i)
-    sprites[i].y = SCREEN_TILES_V * TILE_HEIGHT; // OFF_SCREEN;
-
-  // Turn all G and B tile pieces into sprites, and draw a blank grid where they were
-  for (uint8_t move = 0; move < MAX_MOVABLE_PIECES; ++move) {
-    if (moveInfo[move].piece == 0)
-      break;
-
-    MapSprite2(move * GAMEPIECE_WIDTH * GAMEPIECE_HEIGHT, moveInfo[move].piece == G ? map_green : map_blue, 0);
-    MoveSprite(move * GAMEPIECE_WIDTH * GAMEPIECE_HEIGHT,
-               TILE_WIDTH * (GAMEBOARD_ACTIVE_AREA_LEFT + moveInfo[move].xStart * GAMEPIECE_WIDTH),
-               TILE_HEIGHT * (GAMEBOARD_ACTIVE_AREA_TOP + moveInfo[move].yStart * GAMEPIECE_HEIGHT),
-               GAMEPIECE_WIDTH, GAMEPIECE_HEIGHT);
-
-    DrawMap(GAMEBOARD_ACTIVE_AREA_LEFT + moveInfo[move].xStart * GAMEPIECE_WIDTH,
-            GAMEBOARD_ACTIVE_AREA_TOP + moveInfo[move].yStart * GAMEPIECE_HEIGHT,
-            MapBoardPositionToGridTileMap(moveInfo[move].xStart, moveInfo[move].yStart));
-  }
-
-  // Animate them
-  GravityAnimation(direction);
-
-  for (uint8_t move = 0; move < MAX_MOVABLE_PIECES; ++move) {
-    if (moveInfo[move].piece == 0)
-      break;
-    MoveSprite(move * GAMEPIECE_WIDTH * GAMEPIECE_HEIGHT,
-               TILE_WIDTH * (GAMEBOARD_ACTIVE_AREA_LEFT + moveInfo[move].xEnd * GAMEPIECE_WIDTH),
-               TILE_HEIGHT * (GAMEBOARD_ACTIVE_AREA_TOP + moveInfo[move].yEnd * GAMEPIECE_HEIGHT),
-               GAMEPIECE_WIDTH, GAMEPIECE_HEIGHT);
-  }
+    // Lines that have settled give back what they set aside, then any lines that now fit can start
+    for (uint8_t line = 0; line < sizeof(linePeaks); ++line) {
+      if (!linePeaks[line])
+        continue;
+      bool running = false;
+      for (uint8_t move = 0; move < MAX_MOVABLE_PIECES && moveInfo[move].piece != 0 && !running; ++move)
+        running = ((horizontal ? moveInfo[move].yStart : moveInfo[move].xStart) == line && moveInfo[move].sprite < MOVE_SETTLED);
+      if (!running) {
+        reserved -= linePeaks[line];
+        linePeaks[line] = 0;
+      }
+    }
+    StartWaitingLines(horizontal, &reserved, linePeaks);
 
-  // Turn all G and B sprites back into tile pieces in their end locations, and hide all the sprites
-  for (uint8_t move = 0; move < MAX_MOVABLE_PIECES; ++move) {
-    if (moveInfo[move].piece == 0)
-      break;
-    if (moveInfo[move].piece == G) // Draw green sliders first in case both fell in the exit hole at the same time
-      DrawMap(GAMEBOARD_ACTIVE_AREA_LEFT + moveInfo[move].xEnd * GAMEPIECE_WIDTH,
-              GAMEBOARD_ACTIVE_AREA_TOP + moveInfo[move].yEnd * GAMEPIECE_HEIGHT,
-              MapPieceToTileMapForBoardPosition(moveInfo[move].piece, moveInfo[move].xEnd, moveInfo[move].yEnd));
-  }
+    ramTileStats.frame = RamTiles_Measure();
+    if (ramTileStats.frame > ramTileStats.animation)
+      ramTileStats.animation = ramTileStats.frame;
+#if DEBUG_RAM_TILES
+    RamTiles_DrawStats();
+#endif
 
-  for (uint8_t move = 0; move < MAX_MOVABLE_PIECES; ++move) {
-    if (moveInfo[move].piece == 0)
+    // The main loop's Vram_WaitVsync shows where everything landed, and the next tilt starts on that frame
+    if (snap)
       break;
-    if (moveInfo[move].piece == B) // Ensure blue sliders that fell in the hole will always be drawn on top
-      DrawMap(GAMEBOARD_ACTIVE_AREA_LEFT + moveInfo[move].xEnd * GAMEPIECE_WIDTH,
-              GAMEBOARD_ACTIVE_AREA_TOP + moveInfo[move].yEnd * GAMEPIECE_HEIGHT,
-              MapPieceToTileMapForBoardPosition(moveInfo[move].piece, moveInfo[move].xEnd, moveInfo[move].yEnd));
+    Vram_WaitVsync();
+  } while (!allDoneMoving);
+
+  if (ramTileStats.animation > ramTileStats.highWater) {
+    ramTileStats.highWater = ramTileStats.animation;
+#if DEBUG_RAM_TILES
+    ramTileHighWaterUnsaved = true;
+    RamTiles_DrawStats();
+#endif
   }
+}
+
+// This function expects moveInfo to be populated before calling
+static void AnimateBoard(uint8_t direction)
+{
+  // Hide all sprites
+  for (uint8_t i = 0; i < MAX_SPRITES; ++i)
+    sprites[i].y = SCREEN_TILES_V * TILE_HEIGHT; // OFF_SCREEN;
+
+  // Animate the pieces, each one turns back into tiles in its end location as it stops
+  GravityAnimation(direction);
 
   for (uint8_t i = 0; i < MAX_SPRITES; ++i)
     sprites[i].y = SCREEN_TILES_V * TILE_HEIGHT; // OFF_SCREEN;
+  // The sprites stay in their ram tiles until the kernel takes them down at the next vsync, and if this
+  // tilt needed enough of them, that includes the ones the search table borrows (see SCRATCH)
+  if (ramTileStats.animation > SCRATCH_FIRST_RAM_TILE - GAME_USER_RAM_TILES_COUNT)
+    Vram_WaitVsync();
 }
 
 const uint8_t rf_title[] PROGMEM = {
@@ -774,6 +1884,8 @@ const char pgm_START_GAME[] PROGMEM = "STARTaGAME";
 const char pgm_HOW_TO_PLAY[] PROGMEM = "HOWaTOaPLAY";
 const char pgm_FAIL[] PROGMEM = "FAIL";
 const char pgm_PASS[] PROGMEM = "PASS";
+const char pgm_WAIT[] PROGMEM = "WAIT";
+const char pgm_STUCK[] PROGMEM = "STUCK";
 
 // Generated using ~/uzebox/bin/bin2hex data/HELP.TXT (and terminating with a 0x00)
 const char HELP_TXT[] PROGMEM = {
@@ -796,30 +1908,38 @@ const char HELP_TXT[] PROGMEM = {
   0x20, 0x54, 0x4f, 0x4b, 0x45, 0x4e, 0x53, 0x2e, 0x00
 };
 
+// The 4 pixels of every possible half row of a compressed ram font tile (lowest bit leftmost), in 'fg_color' and 'bg_color'
+static void RamFont_MakeNibbles(uint8_t nibbles[16][4], uint8_t fg_color, uint8_t bg_color)
+{
+  for (uint8_t n = 0; n < 16; ++n)
+    for (uint8_t bit = 0; bit < 4; ++bit)
+      nibbles[n][bit] = (n & (1 << bit)) ? fg_color : bg_color;
+}
+
+// Uncompresses one ram font tile from flash, 4 pixels at a time
+static void RamFont_Expand(uint8_t* ramTile, const uint8_t* tile, uint8_t nibbles[16][4])
+{
+  for (uint8_t row = 0; row < 8; ++row) {
+    uint8_t data = (uint8_t)pgm_read_byte(&tile[row]);
+    memcpy(ramTile, nibbles[data & 0x0F], 4);
+    memcpy(ramTile + 4, nibbles[data >> 4], 4);
+    ramTile += 8;
+  }
+}
+
 // Loads 'len' compressed 'ramfont' tiles into user ram tiles starting at 'user_ram_tile_start' using 'fg_color' and 'bg_color'
 static void RamFont_Load(const uint8_t* ramfont, uint8_t user_ram_tile_start, uint8_t len, uint8_t fg_color, uint8_t bg_color)
 {
   //SetUserRamTilesCount(len); // commented out to avoid flickering of the current level, call manually before this function is called
-  if (fg_color == bg_color) { // This saves 10's of thousands of clock cycles when the condition is met
+  if (fg_color == bg_color) { // This saves thousands of clock cycles when the condition is met
     uint8_t* ramTile = GetUserRamTile(user_ram_tile_start);
     memset(ramTile, fg_color, len * 64);
     return;
   }
-  for (uint8_t tile = 0; tile < len; ++tile) {
-    uint8_t* ramTile = GetUserRamTile(user_ram_tile_start + tile);
-    for (uint8_t row = 0; row < 8; ++row) {
-      uint8_t rowstart = row * 8;
-      uint8_t data = (uint8_t)pgm_read_byte(&ramfont[tile * 8 + row]);
-      uint8_t bit = 0;
-      for (uint8_t bitmask = 1; bitmask != 0; bitmask <<= 1) {
-        if (data & bitmask)
-          ramTile[rowstart + bit] = fg_color;
-        else
-          ramTile[rowstart + bit] = bg_color;
-        ++bit;
-      }
-    }
-  }
+  uint8_t nibbles[16][4];
+  RamFont_MakeNibbles(nibbles, fg_color, bg_color);
+  for (uint8_t tile = 0; tile < len; ++tile)
+    RamFont_Expand(GetUserRamTile(user_ram_tile_start + tile), &ramfont[tile * 8], nibbles);
 }
 
 // Ensure that 4 adjacent letters will pixel fade in differently
@@ -869,7 +1989,27 @@ static void RamFont_Print_Minus_A(uint8_t x, uint8_t y, const char* message, uin
   }
 }
 
-// Compressed ram font data for other characters: *RETUNSOKPZL
+// Points out a board that can't be won where PASS/FAIL would go, using only as many ram tiles as letters
+#define STUCK_X 13
+#define STUCK_Y 23
+static void ShowStuck(bool show)
+{
+  const uint8_t len = sizeof(pgm_STUCK) - 1;
+  if (show) {
+    SetUserRamTilesCount(GAME_USER_RAM_TILES_COUNT + len);
+    for (uint8_t i = 0; i < len; ++i) {
+      RamFont_Load(&rf_title[(pgm_read_byte(&pgm_STUCK[i]) - 'A') * 8], GAME_USER_RAM_TILES_COUNT + i, 1, 0x2F, 0x00);
+      Vram_SetRamTile(STUCK_X + i, STUCK_Y, GAME_USER_RAM_TILES_COUNT + i);
+    }
+  } else {
+    Vram_Push(VRAM_FILL, STUCK_X, STUCK_Y, len, 1, 0, 0);
+    Vram_Finish();
+    SetUserRamTilesCount(GAME_USER_RAM_TILES_COUNT); // the sprites need them back before anything moves
+  }
+  stuckShown = show;
+}
+
+// Compressed ram font data for other characters: *RETUNSOKPZLHI
 // run ramfont/main ramfont-popup.png to generate
 const uint8_t rf_popup[] PROGMEM = {
   0x00, 0x00, 0x18, 0x3c, 0x3c, 0x18, 0x00, 0x00,
@@ -884,6 +2024,10 @@ const uint8_t rf_popup[] PROGMEM = {
   0x3e, 0x63, 0x71, 0x3f, 0x03, 0x03, 0x02, 0x00,
   0x3e, 0x60, 0x30, 0x08, 0x06, 0x7f, 0x3e, 0x00,
   0x02, 0x03, 0x01, 0x01, 0x41, 0x7f, 0x3e, 0x00,
+  0x22, 0x33, 0x33, 0x3f, 0x33, 0x33, 0x33, 0x00,
+  0x3c, 0x18, 0x18, 0x18, 0x18, 0x18, 0x3c, 0x00,
+  0x18, 0x3c, 0x76, 0x72, 0x7f, 0x61, 0x61, 0x00,
+  0x3e, 0x63, 0x01, 0x3f, 0x03, 0x03, 0x03, 0x00,
 };
 
 // Compressed ram font data for popup border
@@ -914,7 +2058,16 @@ const uint8_t rf_digits[] PROGMEM = {
   0x7c, 0xe2, 0xc2, 0xfc, 0xc0, 0xc2, 0x7c, 0x00,
 };
 
-// Defines for the ram fonts used in the popup menu // *RETUNSOKPZL
+// Compressed ram font data for the HINT arrows: left, up, right, down
+// run ramfont/main ramfont-arrows.png to generate
+const uint8_t rf_arrows[] PROGMEM = {
+  0x08, 0x0c, 0x7e, 0x7f, 0x7e, 0x0c, 0x08, 0x00,
+  0x08, 0x1c, 0x3e, 0x7f, 0x1c, 0x1c, 0x1c, 0x00,
+  0x08, 0x18, 0x3f, 0x7f, 0x3f, 0x18, 0x08, 0x00,
+  0x1c, 0x1c, 0x1c, 0x7f, 0x3e, 0x1c, 0x08, 0x00,
+};
+
+// Defines for the ram fonts used in the popup menu // *RETUNSOKPZLHIAF
 #define RF_ASTERISK (GAME_USER_RAM_TILES_COUNT)
 #define RF_R (GAME_USER_RAM_TILES_COUNT + 1)
 #define RF_E (GAME_USER_RAM_TILES_COUNT + 2)
@@ -927,42 +2080,48 @@ const uint8_t rf_digits[] PROGMEM = {
 #define RF_P (GAME_USER_RAM_TILES_COUNT + 9)
 #define RF_Z (GAME_USER_RAM_TILES_COUNT + 10)
 #define RF_L (GAME_USER_RAM_TILES_COUNT + 11)
-
-#define RF_B_TL (GAME_USER_RAM_TILES_COUNT + 12)
-#define RF_B_T (GAME_USER_RAM_TILES_COUNT + 13)
-#define RF_B_TR (GAME_USER_RAM_TILES_COUNT + 14)
-#define RF_B_L (GAME_USER_RAM_TILES_COUNT + 15)
-#define RF_B_R (GAME_USER_RAM_TILES_COUNT + 16)
-#define RF_B_BL (GAME_USER_RAM_TILES_COUNT + 17)
-#define RF_B_B (GAME_USER_RAM_TILES_COUNT + 18)
-#define RF_B_BR (GAME_USER_RAM_TILES_COUNT + 19)
-
-#define RF_OnesPlace (GAME_USER_RAM_TILES_COUNT + 20)
-#define RF_TensPlace (GAME_USER_RAM_TILES_COUNT + 21)
+#define RF_H (GAME_USER_RAM_TILES_COUNT + 12)
+#define RF_I (GAME_USER_RAM_TILES_COUNT + 13)
+#define RF_A (GAME_USER_RAM_TILES_COUNT + 14)
+#define RF_F (GAME_USER_RAM_TILES_COUNT + 15)
+
+#define RF_B_TL (GAME_USER_RAM_TILES_COUNT + 16)
+#define RF_B_T (GAME_USER_RAM_TILES_COUNT + 17)
+#define RF_B_TR (GAME_USER_RAM_TILES_COUNT + 18)
+#define RF_B_L (GAME_USER_RAM_TILES_COUNT + 19)
+#define RF_B_R (GAME_USER_RAM_TILES_COUNT + 20)
+#define RF_B_BL (GAME_USER_RAM_TILES_COUNT + 21)
+#define RF_B_B (GAME_USER_RAM_TILES_COUNT + 22)
+#define RF_B_BR (GAME_USER_RAM_TILES_COUNT + 23)
+
+#define RF_OnesPlace (GAME_USER_RAM_TILES_COUNT + 24)
+#define RF_TensPlace (GAME_USER_RAM_TILES_COUNT + 25)
+#define RF_HintArrow (GAME_USER_RAM_TILES_COUNT + 26)
 
 const uint8_t pgm_P_RETURN[] PROGMEM         = { RF_R, RF_E, RF_T, RF_U, RF_R, RF_N };
+const uint8_t pgm_P_HINT[] PROGMEM           = { RF_H, RF_I, RF_N, RF_T };
 const uint8_t pgm_P_RESET_TOKENS[] PROGMEM   = { RF_R, RF_E, RF_S, RF_E, RF_T, RAM_TILES_COUNT, RF_T, RF_O, RF_K, RF_E, RF_N, RF_S };
 const uint8_t pgm_P_PUZZLE[] PROGMEM        = { RF_P, RF_U, RF_Z, RF_Z, RF_L, RF_E };
+const uint8_t pgm_P_INSTANT_ON[] PROGMEM     = { RF_I, RF_N, RF_S, RF_T, RF_A, RF_N, RF_T, RAM_TILES_COUNT, RF_O, RF_N, RAM_TILES_COUNT };
+const uint8_t pgm_P_INSTANT_OFF[] PROGMEM    = { RF_I, RF_N, RF_S, RF_T, RF_A, RF_N, RF_T, RAM_TILES_COUNT, RF_O, RF_F, RF_F };
 
+// Queued, it is only used on the game screen
 static void RamFont_Print(uint8_t x, uint8_t y, const uint8_t* message, uint8_t len)
 {
-  for (uint8_t i = 0; i < len; ++i) {
-    int8_t tileno = (int8_t)pgm_read_byte(&message[i]);
-    if (tileno >= 0)
-      SetRamTile(x + i, y, tileno);
-  }
+  Vram_Push(VRAM_TEXT, x, y, len, 1, 0, message);
 }
 
+const uint8_t rf_level_colors[] PROGMEM = {
+  0x20, // TILE_NUM_GREEN
+  0x2F, // TILE_NUM_YELLOW
+  0xD0, // TILE_NUM_BLUE
+  0x0E, // TILE_NUM_RED
+};
+
 static uint8_t RamFont_GetLevelColor(uint8_t level)
 {
-  if ((level >= 1) && (level <= 10))
-    return 0x20; // TILE_NUM_GREEN
-  else if ((level >= 11) && (level <= 20))
-    return 0x2F; // TILE_NUM_YELLOW
-  else if ((level >= 21) && (level <= 30))
-    return 0xD0; // TILE_NUM_BLUE
-  else if ((level >= 31) && (level <= 40))
-    return 0x0E; // TILE_NUM_RED
+  if (level >= 1)
+    return (uint8_t)pgm_read_byte(&rf_level_colors[GetBandForLevel(level)]);
   return 0xFF;
 }
 
@@ -971,33 +2130,69 @@ static void RamFont_Load2Digits(const uint8_t* ramfont, uint8_t ramfont_index, u
   uint8_t digits[2] = {0};
   BCD_addConstant(digits, 2, number);
 
-  for (uint8_t tile = 0; tile < 2; ++tile) {
-    uint8_t* ramTile = GetUserRamTile(tile + ramfont_index);
-    for (uint8_t row = 0; row < 8; ++row) {
-      uint8_t rowstart = row * 8;
-      uint8_t data = (uint8_t)pgm_read_byte(&ramfont[digits[tile] * 8 + row]);
-      uint8_t bit = 0;
-      for (uint8_t bitmask = 1; bitmask != 0; bitmask <<= 1) {
-        if (data & bitmask)
-          ramTile[rowstart + bit] = fg_color;
-        else
-          ramTile[rowstart + bit] = bg_color;
-        ++bit;
-      }
-    }
-  }
+  uint8_t nibbles[16][4];
+  RamFont_MakeNibbles(nibbles, fg_color, bg_color);
+  for (uint8_t tile = 0; tile < 2; ++tile)
+    RamFont_Expand(GetUserRamTile(tile + ramfont_index), &ramfont[digits[tile] * 8], nibbles);
 }
 
-int main()
-{
-  ClearVram();
-  SetTileTable(titlescreen);
-  InitMusicPlayer(patches);
+/*
+ * Game states
+ *
+ * main ticks the current state once a frame, right after Vram_WaitVsync, and gives whatever is left
+ * of the frame to the background tasks. A tick handles one frame of input and drawing and returns,
+ * it never waits for the next frame itself. Sliding a level in is a state of its own, so the search
+ * starts on the new board while it slides. Tilting the board still plays out inside the tick that starts
+ * it (see AnimateBoard), since its sprites take over the ram tiles the search works in, and there would
+ * be nothing for the tasks to do. Anything pressed in the meantime waits in the input queue.
+ * Game_SetState runs the new state's enter straight away.
+ */
+#define STATE_TITLE 0
+#define STATE_HOW_TO_PLAY 1
+#define STATE_PLAY 2
+#define STATE_RESULT 3 // PASS or FAIL under the board, waiting for START
+#define STATE_MENU 4   // the popup menu over the board
+#define STATE_SLIDE 5  // the next level sliding in (see Transition_Step)
+#define STATES 6
 
+typedef struct {
+  uint8_t state;
   BUTTON_INFO buttons;
-  memset(&buttons, 0, sizeof(BUTTON_INFO));
+  uint16_t hintTilt; // HINT chosen from the popup menu, played as the next tilt
+  bool confirmed;    // START was pressed on PASS, which turns to WAIT until the next endless mode level is ready
+  uint8_t waited;    // frames WAIT has been up, bounded by ENDLESS_MAX_WAIT
+} __attribute__ ((packed)) GAME;
+
+GAME game;
+
+#define MENU_WIDTH 18
+#define MENU_HEIGHT 7
+#define MENU_START_X 7
+#define MENU_START_Y 12
+#define MENU_ROWS 5 // RETURN, HINT, RESET TOKENS, PUZZLE ## and INSTANT
+#define TILE_NUM_MENU_BACKGROUND TILE_NUM_BACKGROUND
+
+#if MENU_WIDTH * MENU_HEIGHT > WINDOW_BACKING_SIZE
+#error the popup menu does not fit in the window backing
+#endif
+
+typedef struct {
+  uint8_t selection;
+  uint8_t selectedLevel;
+  uint8_t hint;
+} __attribute__ ((packed)) POPUP_MENU;
+
+POPUP_MENU menu;
+
+#define TITLE_TILE_NUM_BACKGROUND 0
+#define TITLE_TILE_NUM_SELECTION 1
+
+uint8_t titleSelection;
+
+static void Game_SetState(uint8_t state);
 
- title_screen:
+static void Title_Enter(void)
+{
   ClearVram();
   SetTileTable(titlescreen);
 
@@ -1014,359 +2209,502 @@ int main()
   RamFont_Print_Minus_A(3, 24, pgm_INVENTED_BY1, sizeof(pgm_INVENTED_BY1) - 1);
   RamFont_Print_Minus_A(15, 25, pgm_INVENTED_BY2, sizeof(pgm_INVENTED_BY2) - 1);
 
-  /* BEGIN TITLE SCREEN SCOPE */ {
-    int8_t prev_selection;
-    int8_t selection = 0;
+  // Draw the menu selection indicator
+  titleSelection = 0;
+  SetTile(9, 14, TITLE_TILE_NUM_SELECTION);
+}
 
-#define TITLE_TILE_NUM_BACKGROUND 0
-#define TITLE_TILE_NUM_SELECTION 1
+// Sets up a new game on the first level, with the board drawn through the vram queue
+static void Play_Start(void)
+{
+  Vram_Discard();
+  ClearVram();
+  SetTileTable(tileset);
+  SetSpritesTileBank(0, tileset);
+  SetUserRamTilesCount(GAME_USER_RAM_TILES_COUNT);
+  Render_Invalidate();
 
-    for (;;) {
-      // Draw the menu selection indicator
-      SetTile(9, 14 + 2 * selection, TITLE_TILE_NUM_SELECTION);
-      prev_selection = selection;
+#if DEBUG_RAM_TILES
+  RamTiles_LoadHighWater();
+#endif
+  currentLevel = 1;
+  LoadLevel(currentLevel);
+  game.hintTilt = 0;
+}
 
-      // Read the current state of the player's controller
-      buttons.prev = buttons.held;
-      buttons.held = ReadJoypad(0);
-      buttons.pressed = buttons.held & (buttons.held ^ buttons.prev);
-      buttons.released = buttons.prev & (buttons.held ^ buttons.prev);
+static void Title_Tick(void)
+{
+  Input_Read(&game.buttons);
 
-      if ((buttons.pressed & BTN_START && buttons.held == BTN_START) ||
-          (buttons.pressed & BTN_A && buttons.held == BTN_A))
-        break;
+  if (Input_Confirmed(&game.buttons)) {
+    TriggerNote(SFX_CHANNEL, SFX_MOUSE_DOWN, SFX_SPEED_MOUSE_DOWN, SFX_VOL_MOUSE_DOWN);
+    if (titleSelection == 0) {
+      Play_Start();
+      Game_SetState(STATE_PLAY);
+    } else
+      Game_SetState(STATE_HOW_TO_PLAY);
+    return;
+  }
 
-      if (buttons.pressed & BTN_UP) {
-        if (selection > 0) {
-          selection--;
-          TriggerNote(SFX_CHANNEL, SFX_MOUSE_DOWN, SFX_SPEED_MOUSE_DOWN, SFX_VOL_MOUSE_DOWN);
-          SetTile(9, 14 + 2 * prev_selection, TITLE_TILE_NUM_BACKGROUND);
-          SetTile(9, 14 + 2 * selection, TITLE_TILE_NUM_SELECTION);
-          prev_selection = selection;
-        }
-      } else if (buttons.pressed & BTN_DOWN) {
-        if (selection < 1) {
-          selection++;
-          TriggerNote(SFX_CHANNEL, SFX_MOUSE_UP, SFX_SPEED_MOUSE_UP, SFX_VOL_MOUSE_UP);
-          SetTile(9, 14 + 2 * prev_selection, TITLE_TILE_NUM_BACKGROUND);
-          SetTile(9, 14 + 2 * selection, TITLE_TILE_NUM_SELECTION);
-          prev_selection = selection;
-        }
-      }
+  uint8_t prev_selection = titleSelection;
+  if ((game.buttons.pressed & BTN_UP) && titleSelection > 0) {
+    titleSelection--;
+    TriggerNote(SFX_CHANNEL, SFX_MOUSE_DOWN, SFX_SPEED_MOUSE_DOWN, SFX_VOL_MOUSE_DOWN);
+  } else if ((game.buttons.pressed & BTN_DOWN) && titleSelection < 1) {
+    titleSelection++;
+    TriggerNote(SFX_CHANNEL, SFX_MOUSE_UP, SFX_SPEED_MOUSE_UP, SFX_VOL_MOUSE_UP);
+  }
+  if (titleSelection != prev_selection) {
+    SetTile(9, 14 + 2 * prev_selection, TITLE_TILE_NUM_BACKGROUND);
+    SetTile(9, 14 + 2 * titleSelection, TITLE_TILE_NUM_SELECTION);
+  }
+}
 
-      WaitVsync(1);
+static void HowToPlay_Enter(void)
+{
+  ClearVram();
+  SetTileTable(tileset);
+
+  // Load the entire alphabet + extras
+  SetUserRamTilesCount(RAM_TILES_COUNT);
+  RamFont_Load(rf_title, 0, sizeof(rf_title) / 8, 0x00, 0x00); // Unused 4 tiles at the end
+
+  int16_t in = 0;
+  uint8_t letter = 0;
+  uint8_t prev_letter = 0;
+  for (uint16_t out = 0; out < SCREEN_TILES_H * SCREEN_TILES_V; ++out, ++in) {
+    uint8_t x = out % SCREEN_TILES_H;
+    prev_letter = letter;
+    letter = pgm_read_byte(&HELP_TXT[in]);
+    uint8_t output;
+    switch (letter) {
+    case 0x00:
+      out = SCREEN_TILES_H * SCREEN_TILES_V;
+      continue;
+      break;
+    case 0x0A:
+      out += SCREEN_TILES_H + SCREEN_TILES_H - 1 - x;
+      if (prev_letter == 0x0A)
+        out -= SCREEN_TILES_H;
+      continue;
+      break;
+    case ' ':
+      output = RAM_TILES_COUNT;
+      break;
+    case ',':
+      output = '[' - 'A';
+      break;
+    case '.':
+      output = '\\' - 'A';
+      break;
+    default:
+      output = letter - 'A';
     }
+    vram[(out / SCREEN_TILES_H + 2) * VRAM_TILES_H + x] = output; // vram rows can be wider than the screen
+  }
 
-    TriggerNote(SFX_CHANNEL, SFX_MOUSE_DOWN, SFX_SPEED_MOUSE_DOWN, SFX_VOL_MOUSE_DOWN);
+  RamFont_SparkleLoad(rf_title, 0, sizeof(rf_title) / 8, 0xFF);
+}
 
-    if (selection == 0)
-      goto start_game;
-  } /* END TITLE SCREEN SCOPE */
-
-  /* BEGIN HOW TO PLAY SCOPE */ {
-    ClearVram();
-    SetTileTable(tileset);
-
-    // Load the entire alphabet + extras
-    SetUserRamTilesCount(RAM_TILES_COUNT);
-    RamFont_Load(rf_title, 0, sizeof(rf_title) / 8, 0x00, 0x00); // Unused 4 tiles at the end
-
-    int16_t in = 0;
-    uint8_t letter = 0;
-    uint8_t prev_letter = 0;
-    for (uint16_t out = 0; out < SCREEN_TILES_H * SCREEN_TILES_V; ++out, ++in) {
-      uint8_t x = out % SCREEN_TILES_H;
-      prev_letter = letter;
-      letter = pgm_read_byte(&HELP_TXT[in]);
-      uint8_t output;
-      switch (letter) {
-      case 0x00:
-        out = SCREEN_TILES_H * SCREEN_TILES_V;
-        continue;
-        break;
-      case 0x0A:
-        out += SCREEN_TILES_H + SCREEN_TILES_H - 1 - x;
-        if (prev_letter == 0x0A)
-          out -= SCREEN_TILES_H;
-        continue;
-        break;
-      case ' ':
-        output = RAM_TILES_COUNT;
-        break;
-      case ',':
-        output = '[' - 'A';
-        break;
-      case '.':
-        output = '\\' - 'A';
-        break;
-      default:
-        output = letter - 'A';
-      }
-      vram[out + SCREEN_TILES_H * 2] = output;
-    }
+static void HowToPlay_Tick(void)
+{
+  Input_Read(&game.buttons);
 
-    RamFont_SparkleLoad(rf_title, 0, sizeof(rf_title) / 8, 0xFF);
+  if (Input_Confirmed(&game.buttons)) {
+    TriggerNote(SFX_CHANNEL, SFX_MOUSE_UP, SFX_SPEED_MOUSE_UP, SFX_VOL_MOUSE_UP);
+    RamFont_SparkleLoad(rf_title, 0, sizeof(rf_title) / 8, 0x00);
+    Game_SetState(STATE_TITLE);
+  }
+}
 
-    for (;;) {
-      // Read the current state of the player's controller
-      buttons.prev = buttons.held;
-      buttons.held = ReadJoypad(0);
-      buttons.pressed = buttons.held & (buttons.held ^ buttons.prev);
-      buttons.released = buttons.prev & (buttons.held ^ buttons.prev);
+// A tilt that moves nothing leaves the board, STUCK and the search on it just as they were
+static void Play_Tilt(uint8_t direction, uint16_t button)
+{
+  TiltBoard(direction);
+  if (!TiltMovedAnything())
+    return;
+  if (stuckShown)
+    ShowStuck(false); // the sprites need its ram tiles, and the board is about to change anyway
+  UpdateBoardAfterMove();
+  AnimateBoard(button);
+}
 
-      if ((buttons.pressed & BTN_START && buttons.held == BTN_START) ||
-          (buttons.pressed & BTN_A && buttons.held == BTN_A)) {
-        TriggerNote(SFX_CHANNEL, SFX_MOUSE_UP, SFX_SPEED_MOUSE_UP, SFX_VOL_MOUSE_UP);
-        RamFont_SparkleLoad(rf_title, 0, sizeof(rf_title) / 8, 0x00);
-        goto title_screen;
-      }
+static void Play_Tick(void)
+{
+  Input_Read(&game.buttons);
 
-      WaitVsync(1);
-    }
-  } /* END HOW TO PLAY SCOPE */
+  // Choosing HINT from the popup menu tilts the board just like pressing the direction would
+  if (game.hintTilt) {
+    game.buttons.pressed = game.hintTilt;
+    game.hintTilt = 0;
+  }
 
- start_game:
-  ClearVram();
-  SetTileTable(tileset);
-  SetSpritesTileBank(0, tileset);
+  if (game.buttons.pressed == BTN_LEFT)
+    Play_Tilt(TILT_LEFT, BTN_LEFT);
+  else if (game.buttons.pressed == BTN_UP)
+    Play_Tilt(TILT_UP, BTN_UP);
+  else if (game.buttons.pressed == BTN_RIGHT)
+    Play_Tilt(TILT_RIGHT, BTN_RIGHT);
+  else if (game.buttons.pressed == BTN_DOWN)
+    Play_Tilt(TILT_DOWN, BTN_DOWN);
+
+  if (youLose || youWin)
+    Game_SetState(STATE_RESULT);
+  else if (Input_Confirmed(&game.buttons)) { // START with no other buttons held down
+    if (stuckShown)
+      ShowStuck(false); // the popup menu needs every ram tile
+    Game_SetState(STATE_MENU);
+  }
+}
+
+// Moves on to a different level, which slides in before play carries on
+static void SlideToLevel(const uint8_t level)
+{
+  Transition_Begin(level);
+  Game_SetState(SCROLLING ? STATE_SLIDE : STATE_PLAY);
+}
+
+static void Slide_Tick(void)
+{
+  if (Transition_Step())
+    Game_SetState(STATE_PLAY);
+}
+
+#define RESULT_X 14
+#define RESULT_Y 23
+#define RESULT_WIDTH 4 // PASS or FAIL
+#define RESULT_HEIGHT 1
+
+#if RESULT_WIDTH * RESULT_HEIGHT > SCRATCH_SMALL_WINDOW
+#error the PASS/FAIL window would overwrite the search table while it runs (see SCRATCH)
+#endif
+
+static void Result_Enter(void)
+{
+  game.confirmed = false;
+  if (!Window_Open(RESULT_X, RESULT_Y, RESULT_WIDTH, RESULT_HEIGHT))
+    return; // START still moves on, there's just nothing to show
+  SetUserRamTilesCount(RAM_TILES_COUNT);
+  RamFont_Load(rf_title, 0, sizeof(rf_title) / 8, youWin ? 0x20 : 0x0E, 0x00);
+
+  if (youLose)
+    Vram_Push(VRAM_TEXT_MINUS_A, RESULT_X, RESULT_Y, RESULT_WIDTH, RESULT_HEIGHT, 0, (const uint8_t*)pgm_FAIL);
+  else if (youWin)
+    Vram_Push(VRAM_TEXT_MINUS_A, RESULT_X, RESULT_Y, RESULT_WIDTH, RESULT_HEIGHT, 0, (const uint8_t*)pgm_PASS);
+}
+
+static void Result_Tick(void)
+{
+  Input_Read(&game.buttons);
+
+  if (!game.confirmed) {
+    if (!Input_Confirmed(&game.buttons))
+      return;
+    game.confirmed = true;
+    game.waited = 0;
+  }
+  // Task_Search and Task_Endless finish the next endless mode level a frame at a time while WAIT is up
+  const bool waiting = youWin && currentLevel >= NUM_LEVELS && !endless.ready;
+  if (waiting && game.waited < ENDLESS_MAX_WAIT) {
+    if (!game.waited++)
+      Vram_Push(VRAM_TEXT_MINUS_A, RESULT_X, RESULT_Y, RESULT_WIDTH, RESULT_HEIGHT, 0, (const uint8_t*)pgm_WAIT);
+    return;
+  }
+
+  // Erase PASS/FAIL message, and take it off the screen before its ram tiles go back to the sprites
+  Window_Close();
+  Vram_Finish();
   SetUserRamTilesCount(GAME_USER_RAM_TILES_COUNT);
 
-  currentLevel = 1;
+  if (youWin) {
+    if (currentLevel < NUM_LEVELS)
+      currentLevel++;
+    else if (waiting)
+      currentLevel = Endless_Fallback(currentLevel);
+    else
+      currentLevel = Endless_NextLevel(currentLevel);
+    SlideToLevel(currentLevel);
+    return;
+  }
   LoadLevel(currentLevel);
+  Game_SetState(STATE_PLAY);
+}
 
-  for (;;) {
-    WaitVsync(1);
-
-    // Read the current state of the player's controller
-    buttons.prev = buttons.held;
-    buttons.held = ReadJoypad(0);
-    buttons.pressed = buttons.held & (buttons.held ^ buttons.prev);
-    buttons.released = buttons.prev & (buttons.held ^ buttons.prev);
-
-    if (buttons.pressed == BTN_LEFT) {
-      TiltBoardLeft();
-      UpdateBoardAfterMove();
-      AnimateBoard(BTN_LEFT);
-    } else if (buttons.pressed == BTN_UP) {
-      TiltBoardUp();
-      UpdateBoardAfterMove();
-      AnimateBoard(BTN_UP);
-    } else if (buttons.pressed == BTN_RIGHT) {
-      TiltBoardRight();
-      UpdateBoardAfterMove();
-      AnimateBoard(BTN_RIGHT);
-    } else if (buttons.pressed == BTN_DOWN) {
-      TiltBoardDown();
-      UpdateBoardAfterMove();
-      AnimateBoard(BTN_DOWN);
-    }
+// Draws the level number after PUZZLE in the color corresponding to its difficulty
+static void Menu_ShowLevel(uint8_t level)
+{
+  RamFont_Load2Digits(rf_digits, RF_OnesPlace, level, RamFont_GetLevelColor(level), 0x00);
+}
 
-    if (youLose || youWin) {
-      SetUserRamTilesCount(RAM_TILES_COUNT);
-      RamFont_Load(rf_title, 0, sizeof(rf_title) / 8, youWin ? 0x20 : 0x0E, 0x00);
-
-      if (youLose)
-        RamFont_Print_Minus_A(14, 23, pgm_FAIL, sizeof(pgm_FAIL) - 1);
-      else if (youWin)
-        RamFont_Print_Minus_A(14, 23, pgm_PASS, sizeof(pgm_PASS) - 1);
-
-      for (;;) {
-        WaitVsync(1);
-
-        // Read the current state of the player's controller
-        buttons.prev = buttons.held;
-        buttons.held = ReadJoypad(0);
-        buttons.pressed = buttons.held & (buttons.held ^ buttons.prev);
-        buttons.released = buttons.prev & (buttons.held ^ buttons.prev);
-
-        if ((buttons.pressed & BTN_START && buttons.held == BTN_START) ||
-            (buttons.pressed & BTN_A && buttons.held == BTN_A)) {
-
-          // Erase PASS/FAIL message
-          for (uint8_t i = 0; i < sizeof(pgm_FAIL) - 1; ++i)
-            SetTile(14 + i, 23, 0);
-
-          SetUserRamTilesCount(GAME_USER_RAM_TILES_COUNT);
-
-          if (youLose) {
-            LoadLevel(currentLevel);
-            break;
-          } else if (youWin) {
-              if (currentLevel < 40)
-                currentLevel++;
-              else
-                currentLevel = 1;
-            LoadLevel(currentLevel);
-            break;
-          }
-        }
-      }
-    } else {
-      // -------------------- PROCESS POPUP MENU --------------------
-      // If we pressed the START button with no other buttons held down
-      if ((buttons.pressed & BTN_START && buttons.held == BTN_START) ||
-          (buttons.pressed & BTN_A && buttons.held == BTN_A)) {
-#define MENU_WIDTH 18
-#define MENU_HEIGHT 5
-#define MENU_START_X 7
-#define MENU_START_Y 12
-#define TILE_NUM_MENU_BACKGROUND TILE_NUM_BACKGROUND
+// Moves the asterisk to a row, with the dpad around it on the rows LEFT and RIGHT change
+static void Menu_Select(uint8_t selection)
+{
+  Vram_Push(VRAM_FILL, MENU_START_X + 1, MENU_START_Y + 1 + menu.selection, 3, 1, TILE_NUM_MENU_BACKGROUND, 0);
+  menu.selection = selection;
+  Vram_SetRamTile(MENU_START_X + 2, MENU_START_Y + 1 + selection, RF_ASTERISK);
+  if (selection >= 3) {
+    Vram_SetTile(MENU_START_X + 1, MENU_START_Y + 1 + selection, TILE_NUM_DPAD_LEFT);
+    Vram_SetTile(MENU_START_X + 3, MENU_START_Y + 1 + selection, TILE_NUM_DPAD_RIGHT);
+  }
+}
 
-        // Play a sound effect that indicates the popup menu, unfortunately if music is playing, a TriggerFx won't work
-        TriggerNote(SFX_CHANNEL, SFX_MOUSE_DOWN, SFX_SPEED_MOUSE_DOWN, SFX_VOL_MOUSE_DOWN);
-
-        // Save what is behind the popup menu
-        uint8_t backing[MENU_HEIGHT][MENU_WIDTH];
-        for (uint8_t y = 0; y < MENU_HEIGHT; ++y)
-          for (uint8_t x = 0; x < MENU_WIDTH; ++x)
-            backing[y][x] = GetTile(MENU_START_X + x, MENU_START_Y + y);
-
-        // Put all the stuff we'll need to display for the menu into user ram tiles
-
-        WaitVsync(1); // Ensures any sprites have a chance to hide before we reuse their ram tiles, avoiding glitches
-        SetUserRamTilesCount(RAM_TILES_COUNT);
-
-        // Load the popup menu into ram tiles starting at 0
-        uint8_t rf_popup_len = sizeof(rf_popup) / 8;
-        RamFont_Load(rf_popup, GAME_USER_RAM_TILES_COUNT, rf_popup_len, 0xFF, 0x00);
-
-        // Load the popup menu border after that (starting at the user ram tile: rf_popup_len) with a different fg color
-        uint8_t rf_popup_border_len = sizeof(rf_popup_border) / 8;
-        RamFont_Load(rf_popup_border, GAME_USER_RAM_TILES_COUNT + rf_popup_len, rf_popup_border_len, 0xA4, 0x00);
-
-        // Make the top right and bottom left pixels of the border "transparent"
-        uint8_t bgTile;
-        char bgTilePixel;
-        uint8_t* ramTile;
-
-        bgTile = GetTile(MENU_START_X + MENU_WIDTH - 1, MENU_START_Y);
-        bgTilePixel = pgm_read_byte(tileset + bgTile * 64 + 7); // 7 is top right pixel
-        ramTile = GetUserRamTile(RF_B_TR); // top right corner in rf_popup
-        ramTile[7] = bgTilePixel; // top right pixel of ramTile
-
-        bgTile = GetTile(MENU_START_X, MENU_START_Y + MENU_HEIGHT - 1);
-        bgTilePixel = pgm_read_byte(tileset + bgTile * 64 + 56); // 56 is bottom left pixel
-        ramTile = GetUserRamTile(RF_B_BL); // bottom left corner in rf_popup
-        ramTile[56] = bgTilePixel; // bottom left pixel of ramTile
-
-        // Draw the current level number in the color corresponding to its difficulty
-        RamFont_Load2Digits(rf_digits,
-                            GAME_USER_RAM_TILES_COUNT + rf_popup_len + rf_popup_border_len,
-                            currentLevel, RamFont_GetLevelColor(currentLevel), 0x00);
-
-        // Draw the menu background
-        Fill(MENU_START_X + 1, MENU_START_Y + 1, MENU_WIDTH - 2, MENU_HEIGHT - 2, TILE_NUM_MENU_BACKGROUND);
-        SetRamTile(MENU_START_X, MENU_START_Y, RF_B_TL);
-        for (uint8_t i = MENU_START_X + 1; i < MENU_START_X + MENU_WIDTH - 1; ++i)
-          SetRamTile(i, MENU_START_Y, RF_B_T);
-        SetRamTile(MENU_START_X + MENU_WIDTH - 1, MENU_START_Y, RF_B_TR);
-        for (uint8_t i = MENU_START_Y + 1; i < MENU_START_Y + MENU_HEIGHT - 1; ++i) {
-          SetRamTile(MENU_START_X, i, RF_B_L);
-          SetRamTile(MENU_START_X + MENU_WIDTH - 1, i, RF_B_R);
-        }
-        SetRamTile(MENU_START_X, MENU_START_Y + MENU_HEIGHT - 1, RF_B_BL);
-        for (uint8_t i = MENU_START_X + 1; i < MENU_START_X + MENU_WIDTH - 1; ++i)
-          SetRamTile(i, MENU_START_Y + MENU_HEIGHT - 1, RF_B_B);
-        SetRamTile(MENU_START_X + MENU_WIDTH - 1, MENU_START_Y + MENU_HEIGHT - 1, RF_B_BR);
-
-        RamFont_Print(MENU_START_X + 5, MENU_START_Y + 1, pgm_P_RETURN, sizeof(pgm_P_RETURN));
-        RamFont_Print(MENU_START_X + 5, MENU_START_Y + 2, pgm_P_RESET_TOKENS, sizeof(pgm_P_RESET_TOKENS));
-        RamFont_Print(MENU_START_X + 5, MENU_START_Y + 3, pgm_P_PUZZLE, sizeof(pgm_P_PUZZLE));
-
-        SetRamTile(MENU_START_X + 5 + 8, MENU_START_Y + 3, RF_OnesPlace);
-        SetRamTile(MENU_START_X + 5 + 7, MENU_START_Y + 3, RF_TensPlace);
-
-        int8_t prev_selection;
-        int8_t selection = 0;
-        bool confirmed = false;
-        uint8_t selectedLevel = currentLevel;
-
-        // The popup menu has its own run loop
-        for (;;) {
-          SetRamTile(MENU_START_X + 2, MENU_START_Y + 1 + selection, RF_ASTERISK);
-          prev_selection = selection;
-
-          // Read the current state of the player's controller
-          buttons.prev = buttons.held;
-          buttons.held = ReadJoypad(0);
-          buttons.pressed = buttons.held & (buttons.held ^ buttons.prev);
-          buttons.released = buttons.prev & (buttons.held ^ buttons.prev);
-
-          if ((buttons.pressed & BTN_START && buttons.held == BTN_START) ||
-              (buttons.pressed & BTN_A && buttons.held == BTN_A)) {
-            confirmed = true;
-            break;
-          }
-
-          if (buttons.pressed & BTN_UP) {
-            if (selection > 0) {
-              selection--;
-              TriggerNote(SFX_CHANNEL, SFX_MOUSE_DOWN, SFX_SPEED_MOUSE_DOWN, SFX_VOL_MOUSE_DOWN);
-              for (uint8_t x = MENU_START_X + 1; x <= MENU_START_X + 3; ++x)
-                SetTile(x, MENU_START_Y + 1 + prev_selection, TILE_NUM_MENU_BACKGROUND);
-              SetRamTile(MENU_START_X + 2, MENU_START_Y + 1 + selection, RF_ASTERISK);
-              prev_selection = selection;
-            }
-          } else if (buttons.pressed & BTN_DOWN) {
-            if (selection < 2) {
-              selection++;
-              TriggerNote(SFX_CHANNEL, SFX_MOUSE_UP, SFX_SPEED_MOUSE_UP, SFX_VOL_MOUSE_UP);
-              for (uint8_t x = MENU_START_X + 1; x <= MENU_START_X + 3; ++x)
-                SetTile(x, MENU_START_Y + 1 + prev_selection, TILE_NUM_MENU_BACKGROUND);
-              SetRamTile(MENU_START_X + 2, MENU_START_Y + 1 + selection, RF_ASTERISK);
-              prev_selection = selection;
-            }
-          }
-          if (selection == 2) {
-            SetTile(MENU_START_X + 1, MENU_START_Y + 1 + selection, TILE_NUM_DPAD_LEFT);
-            SetTile(MENU_START_X + 3, MENU_START_Y + 1 + selection, TILE_NUM_DPAD_RIGHT);
-          }
-
-          if ((selection == 2) && ((buttons.pressed & BTN_LEFT) || (buttons.pressed & BTN_RIGHT))) {
-            if (buttons.pressed & BTN_LEFT) {
-              if (selectedLevel > 1)
-                selectedLevel--;
-              else
-                selectedLevel = 40;
-
-              RamFont_Load2Digits(rf_digits,
-                                  GAME_USER_RAM_TILES_COUNT + rf_popup_len + rf_popup_border_len,
-                                  selectedLevel, RamFont_GetLevelColor(selectedLevel), 0x00);
-              TriggerNote(SFX_CHANNEL, SFX_MOUSE_DOWN, SFX_SPEED_MOUSE_DOWN, SFX_VOL_MOUSE_DOWN);
-            } else if (buttons.pressed & BTN_RIGHT) {
-              if (selectedLevel < 40)
-                selectedLevel++;
-              else
-                selectedLevel = 1;
-
-              RamFont_Load2Digits(rf_digits,
-                                  GAME_USER_RAM_TILES_COUNT + rf_popup_len + rf_popup_border_len,
-                                  selectedLevel, RamFont_GetLevelColor(selectedLevel), 0x00);
-              TriggerNote(SFX_CHANNEL, SFX_MOUSE_UP, SFX_SPEED_MOUSE_UP, SFX_VOL_MOUSE_UP);
-            }
-          }
-
-          WaitVsync(1);
-        }
+static void Menu_Enter(void)
+{
+  // Play a sound effect that indicates the popup menu, unfortunately if music is playing, a TriggerFx won't work
+  TriggerNote(SFX_CHANNEL, SFX_MOUSE_DOWN, SFX_SPEED_MOUSE_DOWN, SFX_VOL_MOUSE_DOWN);
 
-        SetUserRamTilesCount(GAME_USER_RAM_TILES_COUNT);
+  // Work out the hint up front, so it is already showing when the menu appears. Its scratch space is
+  // where the window backing goes, so this comes first (see SCRATCH).
+  menu.hint = GetHint();
 
-        // Restore what was behind the popup menu
-        for (uint8_t y = 0; y < MENU_HEIGHT; ++y)
-          for (uint8_t x = 0; x < MENU_WIDTH; ++x)
-            SetTile(MENU_START_X + x, MENU_START_Y + y, backing[y][x]);
+  // Save what is behind the popup menu, once it is all on screen
+  if (!Window_Open(MENU_START_X, MENU_START_Y, MENU_WIDTH, MENU_HEIGHT)) {
+    Window_Close();
+    Game_SetState(STATE_PLAY);
+    return;
+  }
 
-        TriggerNote(SFX_CHANNEL, SFX_MOUSE_UP, SFX_SPEED_MOUSE_UP, SFX_VOL_MOUSE_UP);
+  // Put all the stuff we'll need to display for the menu into user ram tiles
 
-        if (confirmed && selection == 1)
-          LoadLevel(currentLevel);
-        else if (confirmed && selectedLevel != currentLevel) {
-          currentLevel = selectedLevel;
-          LoadLevel(currentLevel);
-        }
-      }
-      // -------------------- END PROCESS POPUP MENU --------------------
+  Vram_WaitVsync(); // Ensures any sprites have a chance to hide before we reuse their ram tiles, avoiding glitches
+  SetUserRamTilesCount(RAM_TILES_COUNT);
+
+  // Load the popup menu into ram tiles starting at 0
+  uint8_t rf_popup_len = sizeof(rf_popup) / 8;
+  RamFont_Load(rf_popup, GAME_USER_RAM_TILES_COUNT, rf_popup_len, 0xFF, 0x00);
+
+  // Load the popup menu border after that (starting at the user ram tile: rf_popup_len) with a different fg color
+  uint8_t rf_popup_border_len = sizeof(rf_popup_border) / 8;
+  RamFont_Load(rf_popup_border, GAME_USER_RAM_TILES_COUNT + rf_popup_len, rf_popup_border_len, 0xA4, 0x00);
+
+  // Make the top right and bottom left pixels of the border "transparent"
+  uint8_t bgTile;
+  char bgTilePixel;
+  uint8_t* ramTile;
+
+  bgTile = GetTile(MENU_START_X + MENU_WIDTH - 1, MENU_START_Y);
+  bgTilePixel = pgm_read_byte(tileset + bgTile * 64 + 7); // 7 is top right pixel
+  ramTile = GetUserRamTile(RF_B_TR); // top right corner in rf_popup
+  ramTile[7] = bgTilePixel; // top right pixel of ramTile
+
+  bgTile = GetTile(MENU_START_X, MENU_START_Y + MENU_HEIGHT - 1);
+  bgTilePixel = pgm_read_byte(tileset + bgTile * 64 + 56); // 56 is bottom left pixel
+  ramTile = GetUserRamTile(RF_B_BL); // bottom left corner in rf_popup
+  ramTile[56] = bgTilePixel; // bottom left pixel of ramTile
+
+  menu.selectedLevel = currentLevel;
+  Menu_ShowLevel(currentLevel);
+
+  if (menu.hint != HINT_NONE)
+    RamFont_Load(&rf_arrows[menu.hint * 8], RF_HintArrow, 1, 0xFF, 0x00);
+
+  // Draw the menu background
+  Window_DrawFrame(RF_B_TL, TILE_NUM_MENU_BACKGROUND);
+
+  RamFont_Print(MENU_START_X + 5, MENU_START_Y + 1, pgm_P_RETURN, sizeof(pgm_P_RETURN));
+  RamFont_Print(MENU_START_X + 5, MENU_START_Y + 2, pgm_P_HINT, sizeof(pgm_P_HINT));
+  if (menu.hint != HINT_NONE)
+    Vram_SetRamTile(MENU_START_X + 5 + 5, MENU_START_Y + 2, RF_HintArrow);
+  RamFont_Print(MENU_START_X + 5, MENU_START_Y + 3, pgm_P_RESET_TOKENS, sizeof(pgm_P_RESET_TOKENS));
+  RamFont_Print(MENU_START_X + 5, MENU_START_Y + 4, pgm_P_PUZZLE, sizeof(pgm_P_PUZZLE));
+  RamFont_Print(MENU_START_X + 5, MENU_START_Y + 5, instantTilts ? pgm_P_INSTANT_ON : pgm_P_INSTANT_OFF, sizeof(pgm_P_INSTANT_ON));
+
+  Vram_SetRamTile(MENU_START_X + 5 + 8, MENU_START_Y + 4, RF_OnesPlace);
+  Vram_SetRamTile(MENU_START_X + 5 + 7, MENU_START_Y + 4, RF_TensPlace);
+
+  menu.selection = 0;
+  Menu_Select(0);
+}
+
+// Takes the popup menu down and does what was chosen, if anything
+static void Menu_Close(bool confirmed)
+{
+  // Restore what was behind the popup menu, all of it on screen before the sprites get their ram tiles back
+  Window_Close();
+  Vram_Finish();
+  SetUserRamTilesCount(GAME_USER_RAM_TILES_COUNT);
+
+  TriggerNote(SFX_CHANNEL, SFX_MOUSE_UP, SFX_SPEED_MOUSE_UP, SFX_VOL_MOUSE_UP);
+
+  if (confirmed && menu.selection == 1) {
+    if (menu.hint != HINT_NONE)
+      game.hintTilt = (uint16_t)pgm_read_word(&hintButtons[menu.hint]);
+    else
+      LoadLevel(currentLevel); // lost beyond what the search can see, so start over on the known solution
+  } else if (confirmed && menu.selection == 2)
+    LoadLevel(currentLevel);
+  else if (confirmed && menu.selectedLevel != currentLevel) {
+    currentLevel = menu.selectedLevel;
+    SlideToLevel(currentLevel);
+    return;
+  }
+  Game_SetState(STATE_PLAY);
+}
+
+static void Menu_Tick(void)
+{
+  Input_Read(&game.buttons);
+
+  if (Input_Confirmed(&game.buttons)) {
+    Menu_Close(true);
+    return;
+  }
+
+  if (game.buttons.pressed & BTN_UP) {
+    if (menu.selection > 0) {
+      TriggerNote(SFX_CHANNEL, SFX_MOUSE_DOWN, SFX_SPEED_MOUSE_DOWN, SFX_VOL_MOUSE_DOWN);
+      Menu_Select(menu.selection - 1);
+    }
+  } else if (game.buttons.pressed & BTN_DOWN) {
+    if (menu.selection < MENU_ROWS - 1) {
+      TriggerNote(SFX_CHANNEL, SFX_MOUSE_UP, SFX_SPEED_MOUSE_UP, SFX_VOL_MOUSE_UP);
+      Menu_Select(menu.selection + 1);
+    }
+  }
+
+  if ((menu.selection == 3) && ((game.buttons.pressed & BTN_LEFT) || (game.buttons.pressed & BTN_RIGHT))) {
+    if (game.buttons.pressed & BTN_LEFT) {
+      if (menu.selectedLevel > 1 && menu.selectedLevel <= NUM_LEVELS)
+        menu.selectedLevel--;
+      else
+        menu.selectedLevel = NUM_LEVELS;
+
+      Menu_ShowLevel(menu.selectedLevel);
+      TriggerNote(SFX_CHANNEL, SFX_MOUSE_DOWN, SFX_SPEED_MOUSE_DOWN, SFX_VOL_MOUSE_DOWN);
+    } else if (game.buttons.pressed & BTN_RIGHT) {
+      if (menu.selectedLevel < NUM_LEVELS)
+        menu.selectedLevel++;
+      else
+        menu.selectedLevel = 1;
+
+      Menu_ShowLevel(menu.selectedLevel);
+      TriggerNote(SFX_CHANNEL, SFX_MOUSE_UP, SFX_SPEED_MOUSE_UP, SFX_VOL_MOUSE_UP);
     }
+  }
+
+  if ((menu.selection == 4) && ((game.buttons.pressed & BTN_LEFT) || (game.buttons.pressed & BTN_RIGHT))) {
+    instantTilts = !instantTilts;
+    RamFont_Print(MENU_START_X + 5, MENU_START_Y + 5, instantTilts ? pgm_P_INSTANT_ON : pgm_P_INSTANT_OFF, sizeof(pgm_P_INSTANT_ON));
+    if (instantTilts)
+      TriggerNote(SFX_CHANNEL, SFX_MOUSE_UP, SFX_SPEED_MOUSE_UP, SFX_VOL_MOUSE_UP);
+    else
+      TriggerNote(SFX_CHANNEL, SFX_MOUSE_DOWN, SFX_SPEED_MOUSE_DOWN, SFX_VOL_MOUSE_DOWN);
+  }
+}
+
+static void Game_SetState(uint8_t state)
+{
+  game.state = state;
+  switch (state) {
+  case STATE_TITLE:
+    Title_Enter();
+    break;
+  case STATE_HOW_TO_PLAY:
+    HowToPlay_Enter();
+    break;
+  case STATE_RESULT:
+    Result_Enter();
+    break;
+  case STATE_MENU:
+    Menu_Enter();
+    break;
+  }
+}
+
+static void Game_Tick(void)
+{
+  switch (game.state) {
+  case STATE_TITLE:
+    Title_Tick();
+    break;
+  case STATE_HOW_TO_PLAY:
+    HowToPlay_Tick();
+    break;
+  case STATE_PLAY:
+    Play_Tick();
+    break;
+  case STATE_RESULT:
+    Result_Tick();
+    break;
+  case STATE_MENU:
+    Menu_Tick();
+    break;
+  case STATE_SLIDE:
+    Slide_Tick();
+    break;
+  }
+}
+
+/*
+ * Background tasks
+ *
+ * Work that can be spread over many frames runs after the current state's tick, in the order of the
+ * tasks table. Each task gets a budget for every state, in its own units of work sized so the frame
+ * still ends in time, and doesn't run at all in a state whose budget is 0. The kernel keeps the
+ * timers for itself, so the budgets are counted in work rather than measured in cycles.
+ */
+typedef struct {
+  void (*run)(uint8_t budget);
+  uint8_t budget[STATES];
+} __attribute__ ((packed)) TASK;
+
+// Looks for a dead end on the board being played, and points it out as soon as it is certain
+static void Task_Search(uint8_t nodes)
+{
+  Search_Step(nodes);
+  if (game.state == STATE_PLAY && search.owner == SEARCH_FOR_STUCK && search.status == SEARCH_LOST && !stuckShown)
+    ShowStuck(true);
+}
+
+// Works on the next endless mode level with whatever the search isn't using for the current board
+static void Task_Endless(uint8_t steps)
+{
+  while (steps--)
+    Endless_Step();
+}
+
+#if DEBUG_RAM_TILES
+// Writes a new ram tile record to EEPROM while PASS/FAIL waits for START, where stalling a few frames goes unnoticed
+static void Task_SaveRamTiles(uint8_t unused)
+{
+  (void)unused;
+  if (!ramTileHighWaterUnsaved)
+    return;
+  ramTileHighWaterUnsaved = false;
+  RamTiles_SaveHighWater();
+}
+#endif
+
+const TASK tasks[] PROGMEM = {
+  //                     TITLE  HOW_TO_PLAY  PLAY                    RESULT                       MENU  SLIDE
+  { &Task_Search,       { 0,     0,           SEARCH_NODES_PER_FRAME, SEARCH_NODES_PER_IDLE_FRAME, 0,    SEARCH_NODES_PER_FRAME } },
+  { &Task_Endless,      { 0,     0,           1,                      1,                           0,    1 } },
+#if DEBUG_RAM_TILES
+  { &Task_SaveRamTiles, { 0,     0,           0,                      1,                           0,    0 } },
+#endif
+};
+
+static void Tasks_Run(void)
+{
+  for (uint8_t i = 0; i < sizeof(tasks) / sizeof(TASK); ++i) {
+    uint8_t budget = pgm_read_byte(&tasks[i].budget[game.state]);
+    if (budget)
+      ((void (*)(uint8_t))pgm_read_word(&tasks[i].run))(budget);
+  }
+}
 
+int main()
+{
+  ClearVram();
+  SetTileTable(titlescreen);
+  InitMusicPlayer(patches);
+  Input_Init();
+
+  Game_SetState(STATE_TITLE);
+
+  for (;;) {
+    Vram_WaitVsync();
+    Game_Tick();
+    Tasks_Run();
   }
 }
@@ -0,0 +1,111 @@
+// Generated by tools/board -w 5 -h 5 -x 2 -y 2 -o tiltboard.h, do not edit by hand
+
+#define BOARD_WIDTH 5
+#define BOARD_HEIGHT 5
+#define BOARD_HOLE_X 2
+#define BOARD_HOLE_Y 2
+
+// Cells as bits, bit y * BOARD_WIDTH + x
+#define BOARD_MASK_ALL 0x1ffffffUL
+#define BOARD_MASK_FIRST_COLUMN 0x108421UL
+#define BOARD_MASK_LAST_COLUMN 0x1084210UL
+
+// How each cell sits against the hole
+#define BOARD_CELL_PLAIN 0
+#define BOARD_CELL_ABOVE_HOLE 1
+#define BOARD_CELL_LEFT_OF_HOLE 2
+#define BOARD_CELL_RIGHT_OF_HOLE 3
+#define BOARD_CELL_BELOW_HOLE 4
+#define BOARD_CELL_HOLE 5
+#define BOARD_CELL_SHAPES 6
+
+const uint8_t boardCellShapes[] PROGMEM = {
+  0, 0, 0, 0, 0,
+  0, 0, 1, 0, 0,
+  0, 2, 5, 3, 0,
+  0, 0, 4, 0, 0,
+  0, 0, 0, 0, 0,
+};
+
+// Where each piece in a line ends up after a tilt toward cell 0, 3 bits per cell with cell 0 in the
+// low bits. Lines are indexed by their cells as base 3 digits (empty, stopper, piece) with cell 0
+// in the lowest digit. In the tables for lines through the hole, ending up on the hole means
+// falling in. Rows are tilted LEFT from x = 0 and RIGHT from x = BOARD_WIDTH - 1, columns UP from
+// y = 0 and DOWN from y = BOARD_HEIGHT - 1.
+typedef uint16_t TILT_LINE_ENDS;
+#define TILT_LINE_READ(p) pgm_read_word(p)
+
+const TILT_LINE_ENDS tiltLines5[] PROGMEM = {
+  0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0008,
+  0x0008, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+  0x0008, 0x0008, 0x0000, 0x0040, 0x0040, 0x0080, 0x0080, 0x0080,
+  0x0040, 0x0088, 0x0088, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+  0x0000, 0x0000, 0x0008, 0x0008, 0x0000, 0x0000, 0x0000, 0x0000,
+  0x0000, 0x0000, 0x0000, 0x0008, 0x0008, 0x0000, 0x0040, 0x0040,
+  0x0080, 0x0080, 0x0080, 0x0040, 0x0088, 0x0088, 0x0000, 0x0200,
+  0x0200, 0x0400, 0x0400, 0x0400, 0x0200, 0x0408, 0x0408, 0x0600,
+  0x0600, 0x0600, 0x0600, 0x0600, 0x0600, 0x0600, 0x0608, 0x0608,
+  0x0200, 0x0440, 0x0440, 0x0680, 0x0680, 0x0680, 0x0440, 0x0688,
+  0x0688, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+  0x0008, 0x0008, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+  0x0000, 0x0008, 0x0008, 0x0000, 0x0040, 0x0040, 0x0080, 0x0080,
+  0x0080, 0x0040, 0x0088, 0x0088, 0x0000, 0x0000, 0x0000, 0x0000,
+  0x0000, 0x0000, 0x0000, 0x0008, 0x0008, 0x0000, 0x0000, 0x0000,
+  0x0000, 0x0000, 0x0000, 0x0000, 0x0008, 0x0008, 0x0000, 0x0040,
+  0x0040, 0x0080, 0x0080, 0x0080, 0x0040, 0x0088, 0x0088, 0x0000,
+  0x0200, 0x0200, 0x0400, 0x0400, 0x0400, 0x0200, 0x0408, 0x0408,
+  0x0600, 0x0600, 0x0600, 0x0600, 0x0600, 0x0600, 0x0600, 0x0608,
+  0x0608, 0x0200, 0x0440, 0x0440, 0x0680, 0x0680, 0x0680, 0x0440,
+  0x0688, 0x0688, 0x0000, 0x1000, 0x1000, 0x2000, 0x2000, 0x2000,
+  0x1000, 0x2008, 0x2008, 0x3000, 0x3000, 0x3000, 0x3000, 0x3000,
+  0x3000, 0x3000, 0x3008, 0x3008, 0x1000, 0x2040, 0x2040, 0x3080,
+  0x3080, 0x3080, 0x2040, 0x3088, 0x3088, 0x4000, 0x4000, 0x4000,
+  0x4000, 0x4000, 0x4000, 0x4000, 0x4008, 0x4008, 0x4000, 0x4000,
+  0x4000, 0x4000, 0x4000, 0x4000, 0x4000, 0x4008, 0x4008, 0x4000,
+  0x4040, 0x4040, 0x4080, 0x4080, 0x4080, 0x4040, 0x4088, 0x4088,
+  0x1000, 0x2200, 0x2200, 0x3400, 0x3400, 0x3400, 0x2200, 0x3408,
+  0x3408, 0x4600, 0x4600, 0x4600, 0x4600, 0x4600, 0x4600, 0x4600,
+  0x4608, 0x4608, 0x2200, 0x3440, 0x3440, 0x4680, 0x4680, 0x4680,
+  0x3440, 0x4688, 0x4688,
+};
+
+const TILT_LINE_ENDS tiltLines5Hole2[] PROGMEM = {
+  0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0008,
+  0x0008, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+  0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+  0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+  0x0000, 0x0000, 0x0008, 0x0008, 0x0000, 0x0000, 0x0000, 0x0000,
+  0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+  0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0400, 0x0400,
+  0x0400, 0x0400, 0x0400, 0x0400, 0x0400, 0x0408, 0x0408, 0x0000,
+  0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+  0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+  0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+  0x0008, 0x0008, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+  0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+  0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+  0x0000, 0x0000, 0x0000, 0x0008, 0x0008, 0x0000, 0x0000, 0x0000,
+  0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+  0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0400,
+  0x0400, 0x0400, 0x0400, 0x0400, 0x0400, 0x0400, 0x0408, 0x0408,
+  0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+  0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+  0x0000, 0x0000, 0x2000, 0x2000, 0x2000, 0x2000, 0x2000, 0x2000,
+  0x2000, 0x2008, 0x2008, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+  0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+  0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x4000, 0x4000, 0x4000,
+  0x4000, 0x4000, 0x4000, 0x4000, 0x4008, 0x4008, 0x0000, 0x0000,
+  0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+  0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+  0x2400, 0x2400, 0x2400, 0x2400, 0x2400, 0x2400, 0x2400, 0x2408,
+  0x2408, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+  0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+  0x0000, 0x0000, 0x0000,
+};
+
+#define TILT_ROW_LINES tiltLines5
+#define TILT_COLUMN_LINES tiltLines5
+#define TILT_LEFT_HOLE_LINES tiltLines5Hole2
+#define TILT_UP_HOLE_LINES tiltLines5Hole2
+#define TILT_RIGHT_HOLE_LINES tiltLines5Hole2
+#define TILT_DOWN_HOLE_LINES tiltLines5Hole2
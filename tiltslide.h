@@ -0,0 +1,16 @@
+// Generated by tools/slide -w 5 -h 5 -o tiltslide.h, do not edit by hand
+
+#define SLIDE_CELL_PIXELS 16
+#define SLIDE_MAX_CELLS 4
+#define SLIDE_FRAMES 24
+
+// Whole pixels a piece has slid after each frame of a tilt, starting from rest
+const uint8_t slidePixels[SLIDE_FRAMES + 1] PROGMEM = {
+  0, 0, 0, 1, 2, 3, 4, 5, 7, 9, 11, 14,
+  17, 20, 23, 26, 30, 34, 38, 43, 48, 53, 58, 63,
+  69,
+};
+
+// The frame a piece that slides 0 ... SLIDE_MAX_CELLS cells stops on, after which it sits
+// exactly SLIDE_CELL_PIXELS pixels a cell from where it started
+const uint8_t slideLandingFrame[SLIDE_MAX_CELLS + 1] PROGMEM = { 0, 12, 17, 21, 24, };
@@ -0,0 +1,278 @@
+/*
+
+  board.c
+
+  Copyright 2026 Matthew T. Pandina. All rights reserved.
+
+  This file is part of Tilt Puzzle.
+
+  Tilt Puzzle is free software: you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation, either version 3 of the
+  License, or (at your option) any later version.
+
+  Tilt Puzzle is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Tilt Puzzle.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+// Writes the board geometry header for tilt.c: its size, where the hole is, and the tables that
+// depend on them, so the game never has to work any of it out at run time
+//
+// Usage: board [-w width] [-h height] [-x holeX] [-y holeY] [-o tiltboard.h]
+//
+// The tilt kernel treats every row or column as a line of cells, numbered from the wall the pieces
+// slide toward, so one table per line length covers both directions along an axis. A line is
+// indexed by its cells as base 3 digits (empty, stopper, piece) with cell 0 in the lowest digit, and
+// looks up where the piece in each cell ends up, 3 bits per cell with cell 0 in the low bits. A line
+// that crosses the hole has its own table, where ending up on the hole means falling in.
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#define MIN_CELLS 3
+#define MAX_CELLS 7 // 3^7 lines, and a cell number still fits in 3 bits
+#define NO_HOLE 0xFF
+
+#define LINE_EMPTY 0
+#define LINE_STOPPER 1
+#define LINE_PIECE 2
+
+// Line tables already written, so a table shared by two directions is only written once
+typedef struct {
+  uint8_t cells;
+  uint8_t hole;
+} LINE_TABLE;
+
+static LINE_TABLE written[6];
+static unsigned int writtenCount;
+
+static unsigned int LineCount(uint8_t cells)
+{
+  unsigned int count = 1;
+  while (cells--)
+    count *= 3;
+  return count;
+}
+
+// Pieces slide toward cell 0 one after another, so each stops against the last thing that stayed put
+static uint32_t LineEnds(unsigned int line, uint8_t cells, uint8_t hole)
+{
+  uint32_t ends = 0;
+  uint8_t wall = 0; // first cell a piece could come to rest on
+  for (uint8_t i = 0; i < cells; ++i, line /= 3) {
+    uint8_t cell = line % 3;
+    if (i == hole && cell != LINE_EMPTY)
+      return 0; // nothing can sit on the hole, so this line never comes up
+    if (cell == LINE_EMPTY)
+      continue;
+    if (cell == LINE_STOPPER) {
+      wall = i + 1;
+      continue;
+    }
+    if (hole != NO_HOLE && wall <= hole && i > hole) {
+      ends |= (uint32_t)hole << (3 * i); // falls in, and leaves the wall where it was
+      continue;
+    }
+    ends |= (uint32_t)wall << (3 * i);
+    ++wall;
+  }
+  return ends;
+}
+
+static void PrintTableName(FILE* fp, uint8_t cells, uint8_t hole)
+{
+  if (hole == NO_HOLE)
+    fprintf(fp, "tiltLines%u", cells);
+  else
+    fprintf(fp, "tiltLines%uHole%u", cells, hole);
+}
+
+static void WriteTable(FILE* fp, uint8_t cells, uint8_t hole)
+{
+  for (unsigned int i = 0; i < writtenCount; ++i)
+    if (written[i].cells == cells && written[i].hole == hole)
+      return;
+  written[writtenCount].cells = cells;
+  written[writtenCount].hole = hole;
+  ++writtenCount;
+
+  fprintf(fp, "const TILT_LINE_ENDS ");
+  PrintTableName(fp, cells, hole);
+  fprintf(fp, "[] PROGMEM = {");
+  for (unsigned int line = 0; line < LineCount(cells); ++line)
+    fprintf(fp, "%s0x%0*x,", (line % 8) ? " " : "\n  ", (cells > 5) ? 6 : 4, LineEnds(line, cells, hole));
+  fprintf(fp, "\n};\n\n");
+}
+
+static void WriteTableMacro(FILE* fp, const char* name, uint8_t cells, uint8_t hole)
+{
+  fprintf(fp, "#define %s ", name);
+  PrintTableName(fp, cells, hole);
+  fprintf(fp, "\n");
+}
+
+// What the piece on each cell has to look like where it overlaps the hole (see MapPieceToTileMapForBoardPosition)
+static uint8_t CellShape(int x, int y, int holeX, int holeY)
+{
+  if (x == holeX && y == holeY)
+    return 5;
+  if (x == holeX && y == holeY - 1)
+    return 1;
+  if (x == holeX - 1 && y == holeY)
+    return 2;
+  if (x == holeX + 1 && y == holeY)
+    return 3;
+  if (x == holeX && y == holeY + 1)
+    return 4;
+  return 0;
+}
+
+static bool ParseCells(const char* arg, int* value, int min, int max)
+{
+  char* end;
+  long l = strtol(arg, &end, 10);
+  if (*arg == '\0' || *end != '\0' || l < min || l > max)
+    return false;
+  *value = (int)l;
+  return true;
+}
+
+int main(int argc, char *argv[])
+{
+  int width = 5;
+  int height = 5;
+  int holeX = -1;
+  int holeY = -1;
+  const char* path = NULL;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "w:h:x:y:o:")) != -1) {
+    switch (opt) {
+    case 'w':
+      if (!ParseCells(optarg, &width, MIN_CELLS, MAX_CELLS)) {
+        fprintf(stderr, "Width must be between %u and %u\n", MIN_CELLS, MAX_CELLS);
+        return -1;
+      }
+      break;
+    case 'h':
+      if (!ParseCells(optarg, &height, MIN_CELLS, MAX_CELLS)) {
+        fprintf(stderr, "Height must be between %u and %u\n", MIN_CELLS, MAX_CELLS);
+        return -1;
+      }
+      break;
+    case 'x':
+      if (!ParseCells(optarg, &holeX, 0, MAX_CELLS - 1)) {
+        fprintf(stderr, "Hole must be on the board\n");
+        return -1;
+      }
+      break;
+    case 'y':
+      if (!ParseCells(optarg, &holeY, 0, MAX_CELLS - 1)) {
+        fprintf(stderr, "Hole must be on the board\n");
+        return -1;
+      }
+      break;
+    case 'o':
+      path = optarg;
+      break;
+    default:
+      fprintf(stderr, "Usage: %s [-w width] [-h height] [-x holeX] [-y holeY] [-o tiltboard.h]\n", argv[0]);
+      return -1;
+    }
+  }
+
+  // The hole defaults to the middle of the board
+  if (holeX < 0)
+    holeX = width / 2;
+  if (holeY < 0)
+    holeY = height / 2;
+  if (holeX >= width || holeY >= height) {
+    fprintf(stderr, "Hole must be on the board\n");
+    return -1;
+  }
+
+  FILE* fp = path ? fopen(path, "w") : stdout;
+  if (!fp) {
+    fprintf(stderr, "Unable to open %s\n", path);
+    return -1;
+  }
+
+  const char* suffix = (width * height > 32) ? "ULL" : "UL";
+  uint64_t all = 0, firstColumn = 0, lastColumn = 0;
+  for (int y = 0; y < height; ++y)
+    for (int x = 0; x < width; ++x) {
+      uint64_t bit = (uint64_t)1 << (y * width + x);
+      all |= bit;
+      if (x == 0)
+        firstColumn |= bit;
+      if (x == width - 1)
+        lastColumn |= bit;
+    }
+
+  fprintf(fp, "// Generated by tools/board -w %d -h %d -x %d -y %d -o tiltboard.h, do not edit by hand\n\n", width, height, holeX, holeY);
+
+  fprintf(fp, "#define BOARD_WIDTH %d\n", width);
+  fprintf(fp, "#define BOARD_HEIGHT %d\n", height);
+  fprintf(fp, "#define BOARD_HOLE_X %d\n", holeX);
+  fprintf(fp, "#define BOARD_HOLE_Y %d\n\n", holeY);
+
+  fprintf(fp, "// Cells as bits, bit y * BOARD_WIDTH + x\n");
+  fprintf(fp, "#define BOARD_MASK_ALL 0x%llx%s\n", (unsigned long long)all, suffix);
+  fprintf(fp, "#define BOARD_MASK_FIRST_COLUMN 0x%llx%s\n", (unsigned long long)firstColumn, suffix);
+  fprintf(fp, "#define BOARD_MASK_LAST_COLUMN 0x%llx%s\n\n", (unsigned long long)lastColumn, suffix);
+
+  fprintf(fp, "// How each cell sits against the hole\n");
+  fprintf(fp, "#define BOARD_CELL_PLAIN 0\n");
+  fprintf(fp, "#define BOARD_CELL_ABOVE_HOLE 1\n");
+  fprintf(fp, "#define BOARD_CELL_LEFT_OF_HOLE 2\n");
+  fprintf(fp, "#define BOARD_CELL_RIGHT_OF_HOLE 3\n");
+  fprintf(fp, "#define BOARD_CELL_BELOW_HOLE 4\n");
+  fprintf(fp, "#define BOARD_CELL_HOLE 5\n");
+  fprintf(fp, "#define BOARD_CELL_SHAPES 6\n\n");
+  fprintf(fp, "const uint8_t boardCellShapes[] PROGMEM = {");
+  for (int y = 0; y < height; ++y) {
+    fprintf(fp, "\n ");
+    for (int x = 0; x < width; ++x)
+      fprintf(fp, " %u,", CellShape(x, y, holeX, holeY));
+  }
+  fprintf(fp, "\n};\n\n");
+
+  fprintf(fp, "// Where each piece in a line ends up after a tilt toward cell 0, 3 bits per cell with cell 0 in the\n");
+  fprintf(fp, "// low bits. Lines are indexed by their cells as base 3 digits (empty, stopper, piece) with cell 0\n");
+  fprintf(fp, "// in the lowest digit. In the tables for lines through the hole, ending up on the hole means\n");
+  fprintf(fp, "// falling in. Rows are tilted LEFT from x = 0 and RIGHT from x = BOARD_WIDTH - 1, columns UP from\n");
+  fprintf(fp, "// y = 0 and DOWN from y = BOARD_HEIGHT - 1.\n");
+  if (width > 5 || height > 5)
+    fprintf(fp, "typedef uint32_t TILT_LINE_ENDS;\n#define TILT_LINE_READ(p) pgm_read_dword(p)\n\n");
+  else
+    fprintf(fp, "typedef uint16_t TILT_LINE_ENDS;\n#define TILT_LINE_READ(p) pgm_read_word(p)\n\n");
+
+  WriteTable(fp, width, NO_HOLE);
+  WriteTable(fp, height, NO_HOLE);
+  WriteTable(fp, width, holeX);
+  WriteTable(fp, width, width - 1 - holeX);
+  WriteTable(fp, height, holeY);
+  WriteTable(fp, height, height - 1 - holeY);
+
+  WriteTableMacro(fp, "TILT_ROW_LINES", width, NO_HOLE);
+  WriteTableMacro(fp, "TILT_COLUMN_LINES", height, NO_HOLE);
+  WriteTableMacro(fp, "TILT_LEFT_HOLE_LINES", width, holeX);
+  WriteTableMacro(fp, "TILT_UP_HOLE_LINES", height, holeY);
+  WriteTableMacro(fp, "TILT_RIGHT_HOLE_LINES", width, width - 1 - holeX);
+  WriteTableMacro(fp, "TILT_DOWN_HOLE_LINES", height, height - 1 - holeY);
+
+  if (path && fclose(fp) != 0) {
+    fprintf(stderr, "Unable to write %s\n", path);
+    return -1;
+  }
+  return 0;
+}
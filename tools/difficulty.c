@@ -0,0 +1,341 @@
+/*
+
+  difficulty.c
+
+  Copyright 2026 Matthew T. Pandina. All rights reserved.
+
+  This file is part of Tilt Puzzle.
+
+  Tilt Puzzle is free software: you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation, either version 3 of the
+  License, or (at your option) any later version.
+
+  Tilt Puzzle is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Tilt Puzzle.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+// Estimates how hard each level in a pack is from how random and greedy play fare on it, then
+// orders the levels and splits that order into the four difficulty bands
+//
+// Usage: difficulty [-j threads] [-l max_length] [-o levelbands.h] [pack]
+//
+// Rather than sampling playouts, the odds of a playout winning or losing within max_length tilts are
+// worked out exactly over the level's state graph, one tilt at a time from the end (see PlayoutOdds).
+// That costs at most max_length sweeps of the graph, so a level takes well under a millisecond and a
+// pack of thousands of levels takes about a second, most of it exploring the state graphs.
+//
+// The pack defaults to ../levels.h. With -o, the band of every level is written out as the
+// levelBands table that tilt.c reads for the difficulty stripe and the popup menu digits.
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "tiltengine.h"
+#include "tiltsolver.h"
+#include "tiltpack.h"
+#include "taskpool.h"
+
+#define SOLVER_LOG2_CAPACITY 18
+
+typedef struct {
+  uint8_t cells[TILT_LEVEL_SIZE];
+  uint8_t optimal; // TILT_GRAPH_UNSOLVABLE if it can't be won
+  uint32_t states;
+  double randomWin; // odds of a playout ending in each way
+  double randomLoss;
+  double greedyWin;
+  double greedyLoss;
+  double deadEndDensity; // fraction of reachable states from which a win is impossible
+  double score;
+  uint8_t band;
+} LEVEL;
+
+typedef struct {
+  TILT_SOLVER solver;
+  TILT_GRAPH graph;
+  double* odds[2][2]; // [win, loss][tilts left now, one tilt fewer], one per state (see PlayoutOdds)
+} __attribute__ ((aligned (64))) WORKER;
+
+typedef struct {
+  LEVEL* levels;
+  uint32_t numLevels;
+  uint16_t maxLength;
+  WORKER workers[TASKPOOL_MAX_WORKERS];
+} ESTIMATOR;
+
+// The tilts a playout can take from a state, for the odds of each to be averaged. Greedy play takes a win when
+// there is one, never drops a blue unless forced, and otherwise drops as many greens as possible. Returns
+// TILT_GRAPH_WIN or TILT_GRAPH_LOSE when the state decides the playout, else TILT_GRAPH_NONE.
+static uint32_t PlayoutOptions(const TILT_GRAPH* graph, uint32_t state, bool greedy, uint32_t* options, uint8_t* numOptions)
+{
+  const uint32_t* next = graph->next[state];
+  *numOptions = 0;
+  if (!greedy) {
+    for (uint8_t direction = 0; direction < TILT_NUM_DIRECTIONS; ++direction)
+      if (next[direction] != TILT_GRAPH_NONE)
+        options[(*numOptions)++] = next[direction];
+    return TILT_GRAPH_NONE;
+  }
+
+  uint8_t fewestGreens = UINT8_MAX;
+  for (uint8_t direction = 0; direction < TILT_NUM_DIRECTIONS; ++direction) {
+    if (next[direction] == TILT_GRAPH_WIN) {
+      *numOptions = 0;
+      return TILT_GRAPH_WIN;
+    }
+    if (next[direction] >= graph->numStates)
+      continue;
+    uint8_t greens = graph->greens[next[direction]];
+    if (greens < fewestGreens) {
+      fewestGreens = greens;
+      *numOptions = 0;
+    }
+    if (greens == fewestGreens)
+      options[(*numOptions)++] = next[direction];
+  }
+  if (*numOptions == 0)
+    for (uint8_t direction = 0; direction < TILT_NUM_DIRECTIONS; ++direction)
+      if (next[direction] == TILT_GRAPH_LOSE)
+        return TILT_GRAPH_LOSE;
+  return TILT_GRAPH_NONE;
+}
+
+/*
+ * The exact odds of a playout from the start winning and losing within maxLength tilts, the same
+ * numbers that playing it over and over would only estimate. With k tilts left, the odds from a state
+ * are the average over its options of the odds after that tilt with k - 1 left, and with none left
+ * the playout ran out of moves. Sweeping every state k = 1 ... maxLength times gets the answer for the
+ * start, and stops early once a sweep changes nothing.
+ */
+static void PlayoutOdds(WORKER* w, bool greedy, uint16_t maxLength, double* win, double* loss)
+{
+  const TILT_GRAPH* graph = &w->graph;
+  double *winNow = w->odds[0][0], *winBefore = w->odds[0][1];
+  double *lossNow = w->odds[1][0], *lossBefore = w->odds[1][1];
+  for (uint32_t i = 0; i < graph->numStates; ++i)
+    winBefore[i] = lossBefore[i] = 0.0;
+
+  for (uint16_t left = 1; left <= maxLength; ++left) {
+    bool changed = false;
+    for (uint32_t state = 0; state < graph->numStates; ++state) {
+      uint32_t options[TILT_NUM_DIRECTIONS];
+      uint8_t numOptions;
+      uint32_t decided = PlayoutOptions(graph, state, greedy, options, &numOptions);
+      double pWin = (decided == TILT_GRAPH_WIN), pLoss = (decided == TILT_GRAPH_LOSE);
+      for (uint8_t o = 0; o < numOptions; ++o) {
+        if (options[o] == TILT_GRAPH_WIN)
+          pWin += 1.0 / numOptions;
+        else if (options[o] == TILT_GRAPH_LOSE)
+          pLoss += 1.0 / numOptions;
+        else {
+          pWin += winBefore[options[o]] / numOptions;
+          pLoss += lossBefore[options[o]] / numOptions;
+        }
+      }
+      changed |= (pWin != winBefore[state] || pLoss != lossBefore[state]);
+      winNow[state] = pWin;
+      lossNow[state] = pLoss;
+    }
+    double* t = winNow; winNow = winBefore; winBefore = t;
+    t = lossNow; lossNow = lossBefore; lossBefore = t;
+    if (!changed)
+      break;
+  }
+  *win = winBefore[0];
+  *loss = lossBefore[0];
+}
+
+static void EstimateRange(void* context, uint8_t worker, uint64_t begin, uint64_t end)
+{
+  ESTIMATOR* e = context;
+  WORKER* w = &e->workers[worker];
+
+  for (uint64_t index = begin; index < end; ++index) {
+    LEVEL* level = &e->levels[index];
+    TILT_BOARD board;
+    Tilt_FromCells(&board, level->cells);
+
+    if (TiltSolver_BuildGraph(&w->solver, &board, &w->graph) != TILT_SOLVE_OK) {
+      level->optimal = TILT_GRAPH_UNSOLVABLE;
+      continue;
+    }
+    const TILT_GRAPH* graph = &w->graph;
+    level->optimal = graph->dist[0];
+    level->states = graph->numStates;
+
+    uint32_t dead = 0;
+    for (uint32_t i = 0; i < graph->numStates; ++i)
+      if (graph->dist[i] == TILT_GRAPH_UNSOLVABLE)
+        ++dead;
+    level->deadEndDensity = (double)dead / graph->numStates;
+
+    PlayoutOdds(w, false, e->maxLength, &level->randomWin, &level->randomLoss);
+    PlayoutOdds(w, true, e->maxLength, &level->greedyWin, &level->greedyLoss);
+  }
+}
+
+static int CompareScore(const void* a, const void* b)
+{
+  const LEVEL* la = *(const LEVEL* const*)a;
+  const LEVEL* lb = *(const LEVEL* const*)b;
+  if (la->score != lb->score)
+    return (la->score < lb->score) ? -1 : 1;
+  return (la < lb) ? -1 : (la > lb);
+}
+
+int main(int argc, char *argv[])
+{
+  static ESTIMATOR e;
+  uint8_t numWorkers = TaskPool_DefaultWorkers();
+  const char* packPath = "../levels.h";
+  const char* outPath = NULL;
+  e.maxLength = 100;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "j:l:o:")) != -1) {
+    switch (opt) {
+    case 'j':
+      numWorkers = (uint8_t)atoi(optarg);
+      break;
+    case 'l':
+      e.maxLength = (uint16_t)atoi(optarg);
+      break;
+    case 'o':
+      outPath = optarg;
+      break;
+    default:
+      fprintf(stderr, "Usage: %s [-j threads] [-l max_length] [-o levelbands.h] [pack]\n", argv[0]);
+      return -1;
+    }
+  }
+  if (optind < argc)
+    packPath = argv[optind];
+  if (numWorkers < 1 || numWorkers > TASKPOOL_MAX_WORKERS)
+    numWorkers = TaskPool_DefaultWorkers();
+
+  TILT_PACK pack;
+  if (!TiltPack_Open(&pack, packPath)) {
+    fprintf(stderr, "Error: Unable to open \"%s\"\n", packPath);
+    return -1;
+  }
+  uint32_t capacity = 64;
+  e.levels = calloc(capacity, sizeof(LEVEL));
+  uint8_t cells[TILT_LEVEL_SIZE];
+  uint32_t line;
+  uint8_t status;
+  while ((status = TiltPack_Next(&pack, cells, &line)) == TILT_PACK_OK) {
+    if (e.numLevels == capacity) {
+      capacity *= 2;
+      e.levels = realloc(e.levels, capacity * sizeof(LEVEL));
+      memset(&e.levels[e.numLevels], 0, (capacity - e.numLevels) * sizeof(LEVEL));
+    }
+    memcpy(e.levels[e.numLevels++].cells, cells, TILT_LEVEL_SIZE);
+  }
+  TiltPack_Close(&pack);
+  if (status == TILT_PACK_TRUNCATED)
+    fprintf(stderr, "Warning: \"%s\" ends partway through a level, ignoring it\n", packPath);
+  if (e.numLevels == 0) {
+    fprintf(stderr, "Error: No levels in \"%s\"\n", packPath);
+    return -1;
+  }
+
+  for (uint8_t w = 0; w < numWorkers; ++w) {
+    if (!TiltSolver_Init(&e.workers[w].solver, SOLVER_LOG2_CAPACITY) ||
+        !TiltGraph_Init(&e.workers[w].graph, UINT32_C(1) << SOLVER_LOG2_CAPACITY)) {
+      fprintf(stderr, "Unable to allocate the transposition tables\n");
+      return -1;
+    }
+    for (uint8_t i = 0; i < 4; ++i)
+      if (!(e.workers[w].odds[i / 2][i % 2] = malloc((sizeof(double)) << SOLVER_LOG2_CAPACITY))) {
+        fprintf(stderr, "Unable to allocate the playout odds\n");
+        return -1;
+      }
+  }
+
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  TaskPool_Run(numWorkers, e.numLevels, 1, EstimateRange, &e);
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  /*
+   * Each term is roughly 0..1 and grows with difficulty: how often random play fails, how often
+   * sensible-but-shortsighted play fails, how much of the state space is a dead end, and how long
+   * the optimal solution is compared to the longest one in the pack.
+   */
+  uint8_t longest = 1;
+  for (uint32_t i = 0; i < e.numLevels; ++i)
+    if (e.levels[i].optimal != TILT_GRAPH_UNSOLVABLE && e.levels[i].optimal > longest)
+      longest = e.levels[i].optimal;
+  for (uint32_t i = 0; i < e.numLevels; ++i) {
+    LEVEL* level = &e.levels[i];
+    if (level->optimal == TILT_GRAPH_UNSOLVABLE)
+      level->score = 1e9; // always last
+    else
+      level->score = (1.0 - level->randomWin) + (1.0 - level->greedyWin) +
+        level->deadEndDensity + (double)level->optimal / longest;
+  }
+
+  LEVEL** order = malloc(e.numLevels * sizeof(LEVEL*));
+  for (uint32_t i = 0; i < e.numLevels; ++i)
+    order[i] = &e.levels[i];
+  qsort(order, e.numLevels, sizeof(LEVEL*), CompareScore);
+  for (uint32_t rank = 0; rank < e.numLevels; ++rank)
+    order[rank]->band = (uint8_t)((uint64_t)rank * TILT_NUM_BANDS / e.numLevels);
+
+  printf("LEVEL  MOVES  STATES  RANDOM WIN  BLUE LOSS  GREEDY WIN  BLUE LOSS  DEAD ENDS  SCORE  BAND\n");
+  for (uint32_t i = 0; i < e.numLevels; ++i) {
+    const LEVEL* level = &e.levels[i];
+    if (level->optimal == TILT_GRAPH_UNSOLVABLE) {
+      printf("%5u  UNSOLVABLE\n", i + 1);
+      continue;
+    }
+    printf("%5u  %5u  %6u  %9.2f%%  %8.2f%%  %9.2f%%  %8.2f%%  %8.2f%%  %5.3f  %s\n", i + 1, level->optimal, level->states,
+           100.0 * level->randomWin, 100.0 * level->randomLoss, 100.0 * level->greedyWin, 100.0 * level->greedyLoss,
+           100.0 * level->deadEndDensity, level->score, TiltSolver_BandName((TILT_BAND)level->band));
+  }
+  printf("\nDifficulty order (easiest first):");
+  for (uint32_t rank = 0; rank < e.numLevels; ++rank)
+    printf("%s%u", (rank % 20) ? " " : "\n  ", (uint32_t)(order[rank] - e.levels) + 1);
+  double ms = (end.tv_sec - start.tv_sec) * 1000.0 + (end.tv_nsec - start.tv_nsec) / 1000000.0;
+  printf("\n\n%u level(s), playouts of up to %u tilts, in %.2f ms on %u threads\n", e.numLevels, e.maxLength, ms, numWorkers);
+
+  if (outPath) {
+    FILE* fp = fopen(outPath, "w");
+    if (!fp) {
+      fprintf(stderr, "Error: Unable to open \"%s\"\n", outPath);
+      return -1;
+    }
+    fprintf(fp, "// Generated by tools/difficulty (make bands), do not edit by hand\n");
+    fprintf(fp, "//\n// Estimated difficulty order (easiest first):");
+    for (uint32_t rank = 0; rank < e.numLevels; ++rank)
+      fprintf(fp, "%s%u", (rank % 20) ? " " : "\n//   ", (uint32_t)(order[rank] - e.levels) + 1);
+    fprintf(fp, "\n\n// 0 = BEGINNER, 1 = INTERMEDIATE, 2 = ADVANCED, 3 = EXPERT\n");
+    fprintf(fp, "const uint8_t levelBands[] PROGMEM = {");
+    for (uint32_t i = 0; i < e.numLevels; ++i)
+      fprintf(fp, "%s%u,", (i % 10) ? " " : "\n  ", e.levels[i].band);
+    fprintf(fp, "\n};\n");
+    fclose(fp);
+  }
+
+  for (uint8_t w = 0; w < numWorkers; ++w) {
+    TiltSolver_Free(&e.workers[w].solver);
+    TiltGraph_Free(&e.workers[w].graph);
+    for (uint8_t i = 0; i < 4; ++i)
+      free(e.workers[w].odds[i / 2][i % 2]);
+  }
+  free(order);
+  free(e.levels);
+  return 0;
+}
@@ -0,0 +1,301 @@
+/*
+
+  generate.c
+
+  Copyright 2026 Matthew T. Pandina. All rights reserved.
+
+  This file is part of Tilt Puzzle.
+
+  Tilt Puzzle is free software: you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation, either version 3 of the
+  License, or (at your option) any later version.
+
+  Tilt Puzzle is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Tilt Puzzle.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+// Enumerates every board with a given number of stoppers, greens and blues, solves each one that is
+// unique under rotation and reflection, and prints the ones with the longest optimal solutions as
+// levels.h blocks
+//
+// Usage: generate [-j threads] [-k keep] [-m min_moves] [-n first_level_number] stoppers greens blues
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "tiltengine.h"
+#include "tiltsolver.h"
+#include "taskpool.h"
+
+#define NUM_SLOTS (TILT_LEVEL_SIZE - 1) // every cell but the hole
+#define MAX_KEEP 256
+#define SOLVER_LOG2_CAPACITY 18
+
+typedef struct {
+  uint64_t key;
+  uint8_t length;
+  uint32_t states;
+  char moves[TILT_MAX_SOLUTION_LENGTH + 1];
+} CANDIDATE;
+
+typedef struct {
+  TILT_SOLVER solver;
+  CANDIDATE best[MAX_KEEP]; // sorted, best first
+  uint16_t numBest;
+  uint64_t canonical;
+  uint64_t solvable;
+} __attribute__ ((aligned (64))) WORKER;
+
+typedef struct {
+  uint8_t stoppers;
+  uint8_t greens;
+  uint8_t blues;
+  uint8_t minMoves;
+  uint16_t keep;
+  uint64_t movableCombinations;
+  WORKER workers[TASKPOOL_MAX_WORKERS];
+} GENERATOR;
+
+static uint64_t binomial[NUM_SLOTS + 1][NUM_SLOTS + 1];
+static uint8_t cellOfSlot[NUM_SLOTS];
+
+static void InitTables(void)
+{
+  for (uint8_t n = 0; n <= NUM_SLOTS; ++n) {
+    binomial[n][0] = 1;
+    for (uint8_t k = 1; k <= n; ++k)
+      binomial[n][k] = binomial[n - 1][k - 1] + (k <= n - 1 ? binomial[n - 1][k] : 0);
+  }
+  uint8_t slot = 0;
+  for (uint8_t i = 0; i < TILT_LEVEL_SIZE; ++i)
+    if ((UINT32_C(1) << i) != TILT_MASK_HOLE)
+      cellOfSlot[slot++] = i;
+}
+
+// Returns the rank'th k-subset of {0 ... n-1} (combinatorial number system) as a bitmask
+static uint32_t UnrankCombination(uint64_t rank, uint8_t n, uint8_t k)
+{
+  uint32_t mask = 0;
+  for (uint8_t i = k; i > 0; --i) {
+    uint8_t c = i - 1;
+    while (c + 1 < n && binomial[c + 1][i] <= rank)
+      ++c;
+    rank -= binomial[c][i];
+    mask |= UINT32_C(1) << c;
+    n = c;
+  }
+  return mask;
+}
+
+// Maps bit i of mask to the i'th entry of positions
+static uint32_t Scatter(uint32_t mask, const uint8_t* positions)
+{
+  uint32_t out = 0;
+  for (uint8_t i = 0; mask; ++i, mask >>= 1)
+    if (mask & 1)
+      out |= UINT32_C(1) << positions[i];
+  return out;
+}
+
+// Gosper's hack: the next larger integer with the same number of set bits
+static inline uint32_t NextCombination(uint32_t v)
+{
+  uint32_t t = v | (v - 1);
+  return (t + 1) | (((~t & -~t) - 1) >> (__builtin_ctz(v) + 1));
+}
+
+static bool IsBetter(const CANDIDATE* a, const CANDIDATE* b)
+{
+  if (a->length != b->length)
+    return a->length > b->length;
+  if (a->states != b->states)
+    return a->states > b->states;
+  return a->key < b->key;
+}
+
+static void Keep(CANDIDATE* best, uint16_t* numBest, uint16_t keep, const CANDIDATE* c)
+{
+  if (*numBest == keep && !IsBetter(c, &best[keep - 1]))
+    return;
+  uint16_t i = (*numBest < keep) ? (*numBest)++ : keep - 1;
+  while (i > 0 && IsBetter(c, &best[i - 1])) {
+    best[i] = best[i - 1];
+    --i;
+  }
+  best[i] = *c;
+}
+
+static void GenerateRange(void* context, uint8_t worker, uint64_t begin, uint64_t end)
+{
+  GENERATOR* gen = context;
+  WORKER* w = &gen->workers[worker];
+  const uint8_t numMovable = gen->greens + gen->blues;
+  const uint8_t numFree = NUM_SLOTS - gen->stoppers;
+
+  for (uint64_t index = begin; index < end; ++index) {
+    uint64_t stopperRank = index / gen->movableCombinations;
+    uint64_t movableRank = index % gen->movableCombinations;
+
+    TILT_BOARD board = { 0 };
+    uint32_t stopperSlots = UnrankCombination(stopperRank, NUM_SLOTS, gen->stoppers);
+    board.stoppers = Scatter(stopperSlots, cellOfSlot);
+
+    uint8_t freeCells[NUM_SLOTS];
+    uint8_t n = 0;
+    for (uint8_t slot = 0; slot < NUM_SLOTS; ++slot)
+      if (!(stopperSlots & (UINT32_C(1) << slot)))
+        freeCells[n++] = cellOfSlot[slot];
+
+    uint8_t movableCells[TILT_MAX_MOVABLE_PIECES];
+    uint32_t movableSlots = UnrankCombination(movableRank, numFree, numMovable);
+    n = 0;
+    for (uint8_t i = 0; i < numFree; ++i)
+      if (movableSlots & (UINT32_C(1) << i))
+        movableCells[n++] = freeCells[i];
+
+    // Every way of coloring the movable pieces with the requested number of greens
+    const uint32_t allMovable = (UINT32_C(1) << numMovable) - 1;
+    for (uint32_t greenPick = (UINT32_C(1) << gen->greens) - 1; greenPick <= allMovable; greenPick = NextCombination(greenPick)) {
+      board.greens = Scatter(greenPick, movableCells);
+      board.blues = Scatter(allMovable & ~greenPick, movableCells);
+
+      uint64_t key = Tilt_PackKey(&board);
+      if (Tilt_CanonicalKey(&board, NULL) != key)
+        continue;
+      ++w->canonical;
+
+      TILT_SOLUTION solution;
+      if (TiltSolver_Solve(&w->solver, &board, &solution) != TILT_SOLVE_OK)
+        continue;
+      ++w->solvable;
+      if (solution.length < gen->minMoves)
+        continue;
+
+      CANDIDATE c;
+      c.key = key;
+      c.length = solution.length;
+      c.states = solution.states;
+      TiltSolver_SolutionString(&solution, c.moves);
+      Keep(w->best, &w->numBest, gen->keep, &c);
+    }
+  }
+}
+
+static void PrintLevel(const CANDIDATE* c, unsigned int number)
+{
+  static const char cellChars[] = { '0', 'S', 'G', 'B' };
+  printf("  // LEVEL %02u (%u moves: %s)\n", number, c->length, c->moves);
+  for (uint8_t y = 0; y < TILT_BOARD_HEIGHT; ++y) {
+    printf(" ");
+    for (uint8_t x = 0; x < TILT_BOARD_WIDTH; ++x)
+      printf(" %c,", cellChars[(c->key >> (2 * (y * TILT_BOARD_WIDTH + x))) & 3]);
+    printf("\n");
+  }
+  printf("\n");
+}
+
+int main(int argc, char *argv[])
+{
+  static GENERATOR gen;
+  uint8_t numWorkers = TaskPool_DefaultWorkers();
+  unsigned int firstLevel = 41;
+  gen.keep = 10;
+  gen.minMoves = 1;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "j:k:m:n:")) != -1) {
+    switch (opt) {
+    case 'j':
+      numWorkers = (uint8_t)atoi(optarg);
+      break;
+    case 'k':
+      gen.keep = (uint16_t)atoi(optarg);
+      break;
+    case 'm':
+      gen.minMoves = (uint8_t)atoi(optarg);
+      break;
+    case 'n':
+      firstLevel = (unsigned int)atoi(optarg);
+      break;
+    default:
+      argc = 0;
+    }
+  }
+
+  if (argc - optind != 3) {
+    fprintf(stderr, "Usage: %s [-j threads] [-k keep] [-m min_moves] [-n first_level_number] stoppers greens blues\n", argv[0]);
+    return -1;
+  }
+
+  int stoppers = atoi(argv[optind]);
+  int greens = atoi(argv[optind + 1]);
+  int blues = atoi(argv[optind + 2]);
+  if (stoppers < 0 || greens < 1 || blues < 0 || greens + blues > TILT_MAX_MOVABLE_PIECES || stoppers + greens + blues > NUM_SLOTS) {
+    fprintf(stderr, "Need at least 1 green, at most %u greens and blues combined, and at most %u pieces in total\n",
+            TILT_MAX_MOVABLE_PIECES, NUM_SLOTS);
+    return -1;
+  }
+  if (gen.keep < 1 || gen.keep > MAX_KEEP) {
+    fprintf(stderr, "keep must be between 1 and %u\n", MAX_KEEP);
+    return -1;
+  }
+  if (numWorkers < 1 || numWorkers > TASKPOOL_MAX_WORKERS)
+    numWorkers = TaskPool_DefaultWorkers();
+
+  gen.stoppers = (uint8_t)stoppers;
+  gen.greens = (uint8_t)greens;
+  gen.blues = (uint8_t)blues;
+
+  InitTables();
+  Tilt_InitSymmetry();
+
+  for (uint8_t w = 0; w < numWorkers; ++w)
+    if (!TiltSolver_Init(&gen.workers[w].solver, SOLVER_LOG2_CAPACITY)) {
+      fprintf(stderr, "Unable to allocate the transposition tables\n");
+      return -1;
+    }
+
+  // Each index is one placement of stoppers and one placement of movable pieces, colorings are looped over inside
+  gen.movableCombinations = binomial[NUM_SLOTS - gen.stoppers][gen.greens + gen.blues];
+  uint64_t count = binomial[NUM_SLOTS][gen.stoppers] * gen.movableCombinations;
+  fprintf(stderr, "Searching %llu placements on %u threads\n", (unsigned long long)count, numWorkers);
+  TaskPool_Run(numWorkers, count, 64, GenerateRange, &gen);
+
+  // Merge the best of every worker
+  CANDIDATE best[MAX_KEEP];
+  uint16_t numBest = 0;
+  uint64_t canonical = 0, solvable = 0;
+  for (uint8_t w = 0; w < numWorkers; ++w) {
+    for (uint16_t i = 0; i < gen.workers[w].numBest; ++i)
+      Keep(best, &numBest, gen.keep, &gen.workers[w].best[i]);
+    canonical += gen.workers[w].canonical;
+    solvable += gen.workers[w].solvable;
+    TiltSolver_Free(&gen.workers[w].solver);
+  }
+  fprintf(stderr, "%llu unique boards, %llu solvable\n", (unsigned long long)canonical, (unsigned long long)solvable);
+
+  // Print easiest first, with a band comment whenever the band changes, just like levels.h
+  int prevBand = -1;
+  for (uint16_t i = numBest; i > 0; --i) {
+    const CANDIDATE* c = &best[i - 1];
+    TILT_BAND band = TiltSolver_BandForLength(c->length);
+    if ((int)band != prevBand) {
+      printf("  // %s\n", TiltSolver_BandName(band));
+      prevBand = band;
+    }
+    PrintLevel(c, firstLevel + (numBest - i));
+  }
+
+  return 0;
+}
@@ -0,0 +1,325 @@
+/*
+
+  retrograde.c
+
+  Copyright 2026 Matthew T. Pandina. All rights reserved.
+
+  This file is part of Tilt Puzzle.
+
+  Tilt Puzzle is free software: you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation, either version 3 of the
+  License, or (at your option) any later version.
+
+  Tilt Puzzle is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Tilt Puzzle.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+// Builds the distance-to-win table (see tiltdtw.h) for one combination of stopper, green and blue counts
+//
+// Usage: retrograde [-j threads] [-o file] stoppers greens blues
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "tiltengine.h"
+#include "tiltbatch.h"
+#include "tiltdtw.h"
+#include "taskpool.h"
+
+#define MASK_SLOTS (TILT_MASK_BOARD & ~TILT_MASK_HOLE)
+#define NO_STATE UINT32_MAX
+#define BATCH_SIZE 64
+
+/*
+ * Stoppers never move, so the boards that share a stopper layout form their own closed graph:
+ * tilting only rearranges the greens and blues and can drop greens down the hole. Each layout is
+ * solved on its own, so the working set of a worker is every arrangement of up to 'greens' greens
+ * and exactly 'blues' blues around one set of stoppers, a few hundred KB at most.
+ *
+ * Within a layout, states are numbered layer by layer (layer = number of greens left). Every tilt
+ * that moves something without dropping a blue is an edge. Reversing the edges and running a
+ * breadth-first search from layer 0 (all greens gone) gives every state its distance to a win,
+ * states never reached are unsolvable.
+ */
+
+typedef struct {
+  uint32_t* successors;   // [numStates * 4]
+  uint32_t* predStart;    // [numStates + 1], CSR offsets into preds
+  uint32_t* preds;        // [numStates * 4]
+  uint32_t* queue;        // [numStates]
+  uint8_t* dist;          // [numStates]
+} __attribute__ ((aligned (64))) WORKER;
+
+// A run of boards with the same stoppers, tilted in every direction by the vector kernels
+typedef struct {
+  uint32_t stoppers[BATCH_SIZE];
+  uint32_t greens[TILT_NUM_DIRECTIONS][BATCH_SIZE];
+  uint32_t blues[TILT_NUM_DIRECTIONS][BATCH_SIZE];
+  uint8_t results[TILT_NUM_DIRECTIONS][BATCH_SIZE];
+} BATCH;
+
+typedef struct {
+  uint8_t stoppers;
+  uint8_t greens;
+  uint8_t blues;
+  uint8_t numFree;
+  uint32_t numStates; // in one layout, over all layers
+  uint32_t layerOffset[TILT_MAX_MOVABLE_PIECES + 2];
+  uint64_t entriesPerLayout; // size of the last layer, which is what gets written out
+  uint8_t* table;
+  TILT_BATCH_KERNEL kernel; // picked before the workers start, so they only ever read it
+  WORKER workers[TASKPOOL_MAX_WORKERS];
+} BUILDER;
+
+static inline uint32_t LocalIndex(const BUILDER* b, uint32_t free, const TILT_BOARD* board)
+{
+  uint8_t layer = Tilt_CountBits(board->greens);
+  uint64_t blueCombinations = TiltDtw_Binomial(b->numFree - layer, b->blues);
+  return b->layerOffset[layer] +
+    (uint32_t)(TiltDtw_RankSubset(board->greens, free) * blueCombinations +
+               TiltDtw_RankSubset(board->blues, free & ~board->greens));
+}
+
+// Tilts the batched states (numbered from 'first') every way and records where each tilt leads
+static void AddEdges(const BUILDER* b, WORKER* w, uint32_t free, BATCH* batch, uint32_t first, uint32_t count)
+{
+  for (uint32_t i = 0; i < count; ++i) {
+    batch->stoppers[i] = MASK_SLOTS & ~free;
+    for (uint8_t direction = 1; direction < TILT_NUM_DIRECTIONS; ++direction) {
+      batch->greens[direction][i] = batch->greens[0][i];
+      batch->blues[direction][i] = batch->blues[0][i];
+    }
+  }
+  for (uint8_t direction = 0; direction < TILT_NUM_DIRECTIONS; ++direction)
+    Tilt_ApplyBatchWith(b->kernel, batch->stoppers, batch->greens[direction], batch->blues[direction], batch->results[direction], count, (TILT_DIRECTION)direction);
+
+  for (uint32_t i = 0; i < count; ++i)
+    for (uint8_t direction = 0; direction < TILT_NUM_DIRECTIONS; ++direction) {
+      uint8_t result = batch->results[direction][i];
+      uint32_t succ = NO_STATE;
+      if ((result & TILT_RESULT_MOVED) && !(result & TILT_RESULT_LOSE)) {
+        TILT_BOARD next = { batch->stoppers[i], batch->greens[direction][i], batch->blues[direction][i], 0, 0 };
+        succ = LocalIndex(b, free, &next);
+        ++w->predStart[succ + 1];
+      }
+      w->successors[(first + i) * TILT_NUM_DIRECTIONS + direction] = succ;
+    }
+}
+
+static void BuildLayout(BUILDER* b, WORKER* w, uint64_t stopperRank)
+{
+  TILT_BOARD board = { 0 };
+  board.stoppers = TiltDtw_UnrankSubset(stopperRank, b->stoppers, MASK_SLOTS);
+  uint32_t free = MASK_SLOTS & ~board.stoppers;
+
+  // Forward edges, and the in-degree of every state (stored one slot ahead for the prefix sum)
+  memset(w->predStart, 0, (b->numStates + 1) * sizeof(uint32_t));
+  BATCH batch;
+  uint32_t count = 0;
+  uint32_t state = b->layerOffset[1];
+  for (uint8_t layer = 1; layer <= b->greens; ++layer) {
+    uint64_t greenCombinations = TiltDtw_Binomial(b->numFree, layer);
+    uint64_t blueCombinations = TiltDtw_Binomial(b->numFree - layer, b->blues);
+    for (uint64_t g = 0; g < greenCombinations; ++g) {
+      uint32_t greens = TiltDtw_UnrankSubset(g, layer, free);
+      for (uint64_t bl = 0; bl < blueCombinations; ++bl) {
+        batch.greens[0][count] = greens;
+        batch.blues[0][count] = TiltDtw_UnrankSubset(bl, b->blues, free & ~greens);
+        if (++count == BATCH_SIZE) {
+          AddEdges(b, w, free, &batch, state, count);
+          state += count;
+          count = 0;
+        }
+      }
+    }
+  }
+  AddEdges(b, w, free, &batch, state, count);
+
+  // Reverse the edges
+  for (uint32_t i = 0; i < b->numStates; ++i)
+    w->predStart[i + 1] += w->predStart[i];
+  for (uint32_t i = b->layerOffset[1]; i < b->numStates; ++i)
+    for (uint8_t direction = 0; direction < TILT_NUM_DIRECTIONS; ++direction) {
+      uint32_t succ = w->successors[i * TILT_NUM_DIRECTIONS + direction];
+      if (succ != NO_STATE)
+        w->preds[w->predStart[succ]++] = i;
+    }
+  // Filling shifted every offset up to the start of the next state, shift them back
+  for (uint32_t i = b->numStates; i > 0; --i)
+    w->predStart[i] = w->predStart[i - 1];
+  w->predStart[0] = 0;
+
+  // Backward breadth-first search from every won state
+  memset(w->dist, TILT_DTW_UNSOLVABLE, b->numStates);
+  uint32_t head = 0, tail = 0;
+  for (uint32_t i = 0; i < b->layerOffset[1]; ++i) {
+    w->dist[i] = 0;
+    w->queue[tail++] = i;
+  }
+  while (head < tail) {
+    uint32_t j = w->queue[head++];
+    // Distances that don't fit in a byte are left as unsolvable rather than wrapping around
+    if (w->dist[j] + 1 >= TILT_DTW_UNSOLVABLE)
+      continue;
+    for (uint32_t p = w->predStart[j]; p < w->predStart[j + 1]; ++p) {
+      uint32_t i = w->preds[p];
+      if (w->dist[i] == TILT_DTW_UNSOLVABLE) {
+        w->dist[i] = w->dist[j] + 1;
+        w->queue[tail++] = i;
+      }
+    }
+  }
+
+  // The last layer's local order is the same as the order TiltDtw_Index uses
+  memcpy(&b->table[stopperRank * b->entriesPerLayout], &w->dist[b->layerOffset[b->greens]], b->entriesPerLayout);
+}
+
+static void BuildRange(void* context, uint8_t worker, uint64_t begin, uint64_t end)
+{
+  BUILDER* b = context;
+  for (uint64_t stopperRank = begin; stopperRank < end; ++stopperRank)
+    BuildLayout(b, &b->workers[worker], stopperRank);
+}
+
+int main(int argc, char *argv[])
+{
+  static BUILDER b;
+  uint8_t numWorkers = TaskPool_DefaultWorkers();
+  const char* path = NULL;
+  char defaultPath[64];
+
+  int opt;
+  while ((opt = getopt(argc, argv, "j:o:")) != -1) {
+    switch (opt) {
+    case 'j':
+      numWorkers = (uint8_t)atoi(optarg);
+      break;
+    case 'o':
+      path = optarg;
+      break;
+    default:
+      argc = 0;
+    }
+  }
+
+  if (argc - optind != 3) {
+    fprintf(stderr, "Usage: %s [-j threads] [-o file] stoppers greens blues\n", argv[0]);
+    return -1;
+  }
+
+  int stoppers = atoi(argv[optind]);
+  int greens = atoi(argv[optind + 1]);
+  int blues = atoi(argv[optind + 2]);
+  if (stoppers < 0 || greens < 1 || blues < 0 || greens + blues > TILT_MAX_MOVABLE_PIECES || stoppers + greens + blues > TILT_DTW_NUM_SLOTS) {
+    fprintf(stderr, "Need at least 1 green, at most %u greens and blues combined, and at most %u pieces in total\n",
+            TILT_MAX_MOVABLE_PIECES, TILT_DTW_NUM_SLOTS);
+    return -1;
+  }
+  if (numWorkers < 1 || numWorkers > TASKPOOL_MAX_WORKERS)
+    numWorkers = TaskPool_DefaultWorkers();
+
+  b.stoppers = (uint8_t)stoppers;
+  b.greens = (uint8_t)greens;
+  b.blues = (uint8_t)blues;
+  b.numFree = TILT_DTW_NUM_SLOTS - b.stoppers;
+
+  TiltDtw_Init();
+  uint64_t numStates = 0;
+  for (uint8_t layer = 0; layer <= b.greens; ++layer) {
+    b.layerOffset[layer] = (uint32_t)numStates;
+    numStates += TiltDtw_Binomial(b.numFree, layer) * TiltDtw_Binomial(b.numFree - layer, b.blues);
+  }
+  b.layerOffset[b.greens + 1] = (uint32_t)numStates;
+  b.numStates = (uint32_t)numStates;
+  b.entriesPerLayout = numStates - b.layerOffset[b.greens];
+
+  uint64_t numLayouts = TiltDtw_Binomial(TILT_DTW_NUM_SLOTS, b.stoppers);
+  uint64_t entries = TiltDtw_NumEntries(b.stoppers, b.greens, b.blues);
+
+  if (!path) {
+    snprintf(defaultPath, sizeof(defaultPath), "tilt_s%u_g%u_b%u.dtw", b.stoppers, b.greens, b.blues);
+    path = defaultPath;
+  }
+
+  // Workers write their results straight into the mapped output file
+  int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    fprintf(stderr, "Error: Unable to open \"%s\"\n", path);
+    return -1;
+  }
+  size_t size = sizeof(TILT_DTW_HEADER) + entries;
+  if (ftruncate(fd, size) < 0) {
+    fprintf(stderr, "Error: Unable to grow \"%s\" to %zu bytes\n", path, size);
+    close(fd);
+    return -1;
+  }
+  uint8_t* map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) {
+    fprintf(stderr, "Error: Unable to map \"%s\"\n", path);
+    return -1;
+  }
+
+  TILT_DTW_HEADER* header = (TILT_DTW_HEADER*)map;
+  memset(header, 0, sizeof(TILT_DTW_HEADER));
+  memcpy(header->magic, TILT_DTW_MAGIC, sizeof(header->magic));
+  header->stoppers = b.stoppers;
+  header->greens = b.greens;
+  header->blues = b.blues;
+  header->entries = entries;
+  b.table = map + sizeof(TILT_DTW_HEADER);
+
+  for (uint8_t w = 0; w < numWorkers; ++w) {
+    WORKER* worker = &b.workers[w];
+    worker->successors = malloc((size_t)b.numStates * TILT_NUM_DIRECTIONS * sizeof(uint32_t));
+    worker->predStart = malloc(((size_t)b.numStates + 1) * sizeof(uint32_t));
+    worker->preds = malloc((size_t)b.numStates * TILT_NUM_DIRECTIONS * sizeof(uint32_t));
+    worker->queue = malloc((size_t)b.numStates * sizeof(uint32_t));
+    worker->dist = malloc(b.numStates);
+    if (!worker->successors || !worker->predStart || !worker->preds || !worker->queue || !worker->dist) {
+      fprintf(stderr, "Unable to allocate %u states per worker\n", b.numStates);
+      return -1;
+    }
+  }
+
+  b.kernel = Tilt_BatchKernel();
+  fprintf(stderr, "Building %llu layouts of %u states (%llu entries) on %u threads with the %s kernel\n",
+          (unsigned long long)numLayouts, b.numStates, (unsigned long long)entries, numWorkers, Tilt_BatchKernelName(b.kernel));
+  TaskPool_Run(numWorkers, numLayouts, 1, BuildRange, &b);
+
+  // Summarize the table
+  uint64_t histogram[256] = {0};
+  for (uint64_t i = 0; i < entries; ++i)
+    ++histogram[b.table[i]];
+  uint8_t maxDist = 0;
+  for (uint16_t d = 0; d < TILT_DTW_UNSOLVABLE; ++d)
+    if (histogram[d])
+      maxDist = (uint8_t)d;
+  printf("%s: %llu solvable, %llu unsolvable, longest optimal solution %u\n", path,
+         (unsigned long long)(entries - histogram[TILT_DTW_UNSOLVABLE]),
+         (unsigned long long)histogram[TILT_DTW_UNSOLVABLE], maxDist);
+
+  for (uint8_t w = 0; w < numWorkers; ++w) {
+    free(b.workers[w].successors);
+    free(b.workers[w].predStart);
+    free(b.workers[w].preds);
+    free(b.workers[w].queue);
+    free(b.workers[w].dist);
+  }
+  msync(map, size, MS_SYNC);
+  munmap(map, size);
+  return 0;
+}
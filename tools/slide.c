@@ -0,0 +1,144 @@
+/*
+
+  slide.c
+
+  Copyright 2026 Matthew T. Pandina. All rights reserved.
+
+  This file is part of Tilt Puzzle.
+
+  Tilt Puzzle is free software: you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation, either version 3 of the
+  License, or (at your option) any later version.
+
+  Tilt Puzzle is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Tilt Puzzle.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+// Writes the slide header for tilt.c: how far a piece has slid after each frame of a tilt, and the
+// frame it lands on for each number of cells it can slide, so the game never integrates any physics
+//
+// Usage: slide [-w width] [-h height] [-o tiltslide.h]
+//
+// Every piece starts from rest and falls under the same gravity until it stops dead against whatever
+// it slid into, so its whole slide only depends on how many cells it covers. The integration is the
+// one tilt.c used to run every frame, in quarter pixels with the same integer truncation.
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#define MIN_CELLS 3
+#define MAX_CELLS 7 // the same limits as tools/board
+
+#define CELL_PIXELS 16 // GAMEPIECE_WIDTH * TILE_WIDTH (and GAMEPIECE_HEIGHT * TILE_HEIGHT) in tilt.c
+
+#define FP_SHIFT                    (2)
+#define WORLD_FPS                   (24)
+#define WORLD_METER                 (10 << FP_SHIFT)
+#define WORLD_GRAVITY               (615)
+#define WORLD_MAX_VELOCITY          (WORLD_METER * 16)
+
+#define NEAREST_SCREEN_PIXEL(p)  (((p) + (1 << (FP_SHIFT - 1))) >> FP_SHIFT)
+
+#define MAX_FRAMES 255
+
+static bool ParseCells(const char* arg, int* value, int min, int max)
+{
+  char* end;
+  long l = strtol(arg, &end, 10);
+  if (*arg == '\0' || *end != '\0' || l < min || l > max)
+    return false;
+  *value = (int)l;
+  return true;
+}
+
+int main(int argc, char *argv[])
+{
+  int width = 5;
+  int height = 5;
+  const char* path = NULL;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "w:h:o:")) != -1) {
+    switch (opt) {
+    case 'w':
+      if (!ParseCells(optarg, &width, MIN_CELLS, MAX_CELLS)) {
+        fprintf(stderr, "Width must be between %u and %u\n", MIN_CELLS, MAX_CELLS);
+        return -1;
+      }
+      break;
+    case 'h':
+      if (!ParseCells(optarg, &height, MIN_CELLS, MAX_CELLS)) {
+        fprintf(stderr, "Height must be between %u and %u\n", MIN_CELLS, MAX_CELLS);
+        return -1;
+      }
+      break;
+    case 'o':
+      path = optarg;
+      break;
+    default:
+      fprintf(stderr, "Usage: %s [-w width] [-h height] [-o tiltslide.h]\n", argv[0]);
+      return -1;
+    }
+  }
+
+  // The longest slide goes from one edge of the board to the other
+  int maxCells = ((width > height) ? width : height) - 1;
+
+  // Quarter pixels slid after each frame, until the longest slide is over
+  int16_t slid[MAX_FRAMES + 1] = {0};
+  uint8_t landing[MAX_CELLS] = {0};
+  int frames = 0;
+  int16_t p = 0;
+  int16_t v = 0;
+  for (int cells = 1; cells <= maxCells; ++cells) {
+    while (p < ((cells * CELL_PIXELS) << FP_SHIFT)) {
+      p += v / WORLD_FPS;
+      v += WORLD_GRAVITY / WORLD_FPS;
+      if (v > WORLD_MAX_VELOCITY)
+        v = WORLD_MAX_VELOCITY;
+      slid[++frames] = p;
+    }
+    landing[cells] = (uint8_t)frames;
+  }
+
+  FILE* fp = path ? fopen(path, "w") : stdout;
+  if (!fp) {
+    fprintf(stderr, "Unable to open %s\n", path);
+    return -1;
+  }
+
+  fprintf(fp, "// Generated by tools/slide -w %d -h %d -o tiltslide.h, do not edit by hand\n\n", width, height);
+
+  fprintf(fp, "#define SLIDE_CELL_PIXELS %d\n", CELL_PIXELS);
+  fprintf(fp, "#define SLIDE_MAX_CELLS %d\n", maxCells);
+  fprintf(fp, "#define SLIDE_FRAMES %d\n\n", frames);
+
+  fprintf(fp, "// Whole pixels a piece has slid after each frame of a tilt, starting from rest\n");
+  fprintf(fp, "const uint8_t slidePixels[SLIDE_FRAMES + 1] PROGMEM = {");
+  for (int frame = 0; frame <= frames; ++frame)
+    fprintf(fp, "%s%u,", (frame % 12) ? " " : "\n  ", NEAREST_SCREEN_PIXEL(slid[frame]));
+  fprintf(fp, "\n};\n\n");
+
+  fprintf(fp, "// The frame a piece that slides 0 ... SLIDE_MAX_CELLS cells stops on, after which it sits\n");
+  fprintf(fp, "// exactly SLIDE_CELL_PIXELS pixels a cell from where it started\n");
+  fprintf(fp, "const uint8_t slideLandingFrame[SLIDE_MAX_CELLS + 1] PROGMEM = {");
+  for (int cells = 0; cells <= maxCells; ++cells)
+    fprintf(fp, " %u,", landing[cells]);
+  fprintf(fp, " };\n");
+
+  if (path && fclose(fp) != 0) {
+    fprintf(stderr, "Unable to write %s\n", path);
+    return -1;
+  }
+  return 0;
+}
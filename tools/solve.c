@@ -0,0 +1,198 @@
+/*
+
+  solve.c
+
+  Copyright 2026 Matthew T. Pandina. All rights reserved.
+
+  This file is part of Tilt Puzzle.
+
+  Tilt Puzzle is free software: you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation, either version 3 of the
+  License, or (at your option) any later version.
+
+  Tilt Puzzle is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Tilt Puzzle.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+// Reports the shortest tilt sequence that solves each level in levels.h
+//
+// Usage: solve [-c cache] [-o levelhints.h] [level]
+//
+// With -c, results are kept in the given file (see tiltcache.h) and only levels that changed are solved again.
+// With -o, every solution is also written out packed 2 bits per tilt for the in-game HINT.
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "tiltengine.h"
+#include "tiltsolver.h"
+#include "tiltcache.h"
+
+#define PROGMEM
+#include "../levels.h"
+
+#define NUM_LEVELS (sizeof(levelData) / TILT_LEVEL_SIZE)
+
+static bool WriteHints(const char* path, const TILT_SOLUTION* solutions)
+{
+  FILE* fp = fopen(path, "w");
+  if (!fp)
+    return false;
+
+  uint8_t maxLength = 0;
+  for (unsigned int i = 0; i < NUM_LEVELS; ++i)
+    if (solutions[i].length > maxLength)
+      maxLength = solutions[i].length;
+
+  fprintf(fp, "// Generated by tools/solve -o levelhints.h, do not edit by hand\n");
+  fprintf(fp, "//\n// One optimal solution per level, 2 bits per tilt with the first tilt in the low bits\n");
+  fprintf(fp, "// (0 = LEFT, 1 = UP, 2 = RIGHT, 3 = DOWN). Level N starts at levelHints[levelHintOffsets[N - 1]].\n\n");
+  fprintf(fp, "#define LEVEL_HINTS_MAX_LENGTH %u\n\n", maxLength);
+
+  // Endless mode levels get their band on the device, so it needs the cut-offs TiltSolver_BandForLength uses
+  fprintf(fp, "// The longest optimal solution in each difficulty band but the last (see TiltSolver_BandForLength)\n");
+  fprintf(fp, "const uint8_t levelBandMaxLengths[] PROGMEM = {");
+  unsigned int length = 0;
+  for (unsigned int band = 0; band < TILT_NUM_BANDS - 1; ++band) {
+    while (length < UINT8_MAX && TiltSolver_BandForLength((uint8_t)(length + 1)) <= band)
+      ++length;
+    fprintf(fp, "%s%u", band ? ", " : " ", length);
+  }
+  fprintf(fp, " };\n\n");
+
+  fprintf(fp, "const uint8_t levelHintLengths[] PROGMEM = {");
+  for (unsigned int i = 0; i < NUM_LEVELS; ++i)
+    fprintf(fp, "%s%u,", (i % 10) ? " " : "\n  ", solutions[i].length);
+  fprintf(fp, "\n};\n\n");
+
+  fprintf(fp, "const uint16_t levelHintOffsets[] PROGMEM = {");
+  unsigned int offset = 0;
+  for (unsigned int i = 0; i < NUM_LEVELS; ++i) {
+    fprintf(fp, "%s%u,", (i % 10) ? " " : "\n  ", offset);
+    offset += (solutions[i].length + 3) / 4;
+  }
+  fprintf(fp, "\n};\n\n");
+
+  fprintf(fp, "const uint8_t levelHints[] PROGMEM = {\n");
+  for (unsigned int i = 0; i < NUM_LEVELS; ++i) {
+    char moves[TILT_MAX_SOLUTION_LENGTH + 1];
+    TiltSolver_SolutionString(&solutions[i], moves);
+    fprintf(fp, "  // LEVEL %02u: %s\n ", i + 1, moves);
+    for (uint8_t move = 0; move < solutions[i].length; move += 4) {
+      uint8_t packed = 0;
+      for (uint8_t j = 0; j < 4 && move + j < solutions[i].length; ++j)
+        packed |= solutions[i].moves[move + j] << (j * 2);
+      fprintf(fp, " 0x%02x,", packed);
+    }
+    fprintf(fp, "\n");
+  }
+  fprintf(fp, "};\n");
+
+  return fclose(fp) == 0;
+}
+
+int main(int argc, char *argv[])
+{
+  unsigned int first = 1;
+  unsigned int last = NUM_LEVELS;
+  const char* cachePath = NULL;
+  const char* hintsPath = NULL;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "c:o:")) != -1) {
+    switch (opt) {
+    case 'c':
+      cachePath = optarg;
+      break;
+    case 'o':
+      hintsPath = optarg;
+      break;
+    default:
+      fprintf(stderr, "Usage: %s [-c cache] [-o levelhints.h] [level]\n", argv[0]);
+      return -1;
+    }
+  }
+
+  if (optind < argc && hintsPath) {
+    fprintf(stderr, "Hints need every level, so -o can't be combined with a level\n");
+    return -1;
+  }
+  if (optind < argc) {
+    first = last = (unsigned int)atoi(argv[optind]);
+    if (first < 1 || first > NUM_LEVELS) {
+      fprintf(stderr, "Level must be between 1 and %u\n", (unsigned int)NUM_LEVELS);
+      return -1;
+    }
+  }
+
+  TILT_SOLVER solver;
+  if (!TiltSolver_Init(&solver, TILT_SOLVER_DEFAULT_LOG2_CAPACITY)) {
+    fprintf(stderr, "Unable to allocate the transposition table\n");
+    return -1;
+  }
+
+  TILT_CACHE cache;
+  if (cachePath && !TiltCache_Open(&cache, cachePath)) {
+    fprintf(stderr, "Unable to allocate the solution cache\n");
+    return -1;
+  }
+
+  static TILT_SOLUTION solutions[NUM_LEVELS];
+  int retval = 0;
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  for (unsigned int level = first; level <= last; ++level) {
+    TILT_BOARD board;
+    Tilt_FromCells(&board, &levelData[(level - 1) * TILT_LEVEL_SIZE]);
+
+    TILT_SOLUTION solution;
+    solution.length = 0;
+    char moves[TILT_MAX_SOLUTION_LENGTH + 1];
+    switch (cachePath ? TiltCache_Solve(&cache, &solver, &board, &solution) : TiltSolver_Solve(&solver, &board, &solution)) {
+    case TILT_SOLVE_OK:
+      TiltSolver_SolutionString(&solution, moves);
+      printf("LEVEL %02u: %2u moves  %-16s (%u states)\n", level, solution.length, moves, solution.states);
+      break;
+    case TILT_SOLVE_UNSOLVABLE:
+      printf("LEVEL %02u: UNSOLVABLE (%u states)\n", level, solution.states);
+      retval = 1;
+      break;
+    default:
+      printf("LEVEL %02u: transposition table overflow (%u states)\n", level, solution.states);
+      retval = 1;
+      break;
+    }
+    solutions[level - 1] = solution;
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  double ms = (end.tv_sec - start.tv_sec) * 1000.0 + (end.tv_nsec - start.tv_nsec) / 1000000.0;
+  printf("Solved %u level(s) in %.2f ms", last - first + 1, ms);
+  if (cachePath) {
+    printf(" (%u from %s)", cache.hits, cachePath);
+    if (!TiltCache_Close(&cache))
+      fprintf(stderr, "\nError: Unable to write \"%s\"", cachePath);
+  }
+  printf("\n");
+
+  // Hints for a pack that can't be solved would send the player the wrong way
+  if (hintsPath && !retval && !WriteHints(hintsPath, solutions)) {
+    fprintf(stderr, "Error: Unable to write \"%s\"\n", hintsPath);
+    retval = -1;
+  }
+
+  TiltSolver_Free(&solver);
+  return retval;
+}
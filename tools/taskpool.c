@@ -0,0 +1,203 @@
+/*
+
+  taskpool.c
+
+  Copyright 2026 Matthew T. Pandina. All rights reserved.
+
+  This file is part of Tilt Puzzle.
+
+  Tilt Puzzle is free software: you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation, either version 3 of the
+  License, or (at your option) any later version.
+
+  Tilt Puzzle is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Tilt Puzzle.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "taskpool.h"
+
+// Splitting a range in half each time keeps the depth of a deque at roughly log2(count / grain)
+#define DEQUE_CAPACITY 128
+
+typedef struct {
+  uint64_t begin;
+  uint64_t end;
+} RANGE;
+
+typedef struct {
+  pthread_mutex_t lock;
+  RANGE ranges[DEQUE_CAPACITY];
+  uint8_t top;    // oldest range, taken by thieves
+  uint8_t bottom; // one past the newest range, pushed and popped by the owner
+} __attribute__ ((aligned (64))) DEQUE;
+
+typedef struct {
+  DEQUE deques[TASKPOOL_MAX_WORKERS];
+  pthread_t threads[TASKPOOL_MAX_WORKERS];
+  uint8_t numWorkers;
+  uint64_t grain;
+  TASKPOOL_FUNC func;
+  void* context;
+  _Atomic uint64_t remaining; // indices that have not finished running yet
+} POOL;
+
+typedef struct {
+  POOL* pool;
+  uint8_t worker;
+} WORKER_ARGS;
+
+uint8_t TaskPool_DefaultWorkers(void)
+{
+  long n = sysconf(_SC_NPROCESSORS_ONLN);
+  if (n < 1)
+    n = 1;
+  if (n > TASKPOOL_MAX_WORKERS)
+    n = TASKPOOL_MAX_WORKERS;
+  return (uint8_t)n;
+}
+
+static bool PushBottom(DEQUE* deque, RANGE range)
+{
+  bool pushed = false;
+  pthread_mutex_lock(&deque->lock);
+  if (deque->bottom == DEQUE_CAPACITY && deque->top > 0) {
+    memmove(deque->ranges, &deque->ranges[deque->top], (deque->bottom - deque->top) * sizeof(RANGE));
+    deque->bottom -= deque->top;
+    deque->top = 0;
+  }
+  if (deque->bottom < DEQUE_CAPACITY) {
+    deque->ranges[deque->bottom++] = range;
+    pushed = true;
+  }
+  pthread_mutex_unlock(&deque->lock);
+  return pushed;
+}
+
+static bool PopBottom(DEQUE* deque, RANGE* range)
+{
+  bool popped = false;
+  pthread_mutex_lock(&deque->lock);
+  if (deque->bottom > deque->top) {
+    *range = deque->ranges[--deque->bottom];
+    popped = true;
+  }
+  if (deque->bottom == deque->top)
+    deque->bottom = deque->top = 0;
+  pthread_mutex_unlock(&deque->lock);
+  return popped;
+}
+
+static bool StealTop(DEQUE* deque, RANGE* range)
+{
+  bool stolen = false;
+  // Don't wait on a busy victim, there are others to try
+  if (pthread_mutex_trylock(&deque->lock) != 0)
+    return false;
+  if (deque->bottom > deque->top) {
+    *range = deque->ranges[deque->top++];
+    stolen = true;
+  }
+  if (deque->bottom == deque->top)
+    deque->bottom = deque->top = 0;
+  pthread_mutex_unlock(&deque->lock);
+  return stolen;
+}
+
+static void RunRange(POOL* pool, uint8_t worker, RANGE range)
+{
+  DEQUE* own = &pool->deques[worker];
+  while (range.end - range.begin > pool->grain) {
+    uint64_t mid = range.begin + (range.end - range.begin) / 2;
+    if (!PushBottom(own, (RANGE){ mid, range.end }))
+      break;
+    range.end = mid;
+  }
+  pool->func(pool->context, worker, range.begin, range.end);
+  atomic_fetch_sub(&pool->remaining, range.end - range.begin);
+}
+
+static void* WorkerThread(void* arg)
+{
+  WORKER_ARGS* args = arg;
+  POOL* pool = args->pool;
+  uint8_t worker = args->worker;
+  uint32_t seed = worker * 2654435761u + 1;
+
+  while (atomic_load(&pool->remaining) > 0) {
+    RANGE range;
+    if (PopBottom(&pool->deques[worker], &range)) {
+      RunRange(pool, worker, range);
+      continue;
+    }
+
+    bool stolen = false;
+    seed = seed * 1103515245u + 12345u;
+    uint8_t first = (seed >> 16) % pool->numWorkers;
+    for (uint8_t i = 0; i < pool->numWorkers && !stolen; ++i) {
+      uint8_t victim = (first + i) % pool->numWorkers;
+      if (victim != worker)
+        stolen = StealTop(&pool->deques[victim], &range);
+    }
+    if (stolen)
+      RunRange(pool, worker, range);
+    else
+      sched_yield();
+  }
+  return NULL;
+}
+
+void TaskPool_Run(uint8_t numWorkers, uint64_t count, uint64_t grain, TASKPOOL_FUNC func, void* context)
+{
+  static POOL pool;
+  WORKER_ARGS args[TASKPOOL_MAX_WORKERS];
+
+  if (numWorkers < 1)
+    numWorkers = 1;
+  if (numWorkers > TASKPOOL_MAX_WORKERS)
+    numWorkers = TASKPOOL_MAX_WORKERS;
+  if (grain < 1)
+    grain = 1;
+
+  pool.numWorkers = numWorkers;
+  pool.grain = grain;
+  pool.func = func;
+  pool.context = context;
+  atomic_store(&pool.remaining, count);
+
+  // Deal the range out evenly to start with, stealing evens out whatever imbalance remains
+  for (uint8_t w = 0; w < numWorkers; ++w) {
+    DEQUE* deque = &pool.deques[w];
+    pthread_mutex_init(&deque->lock, NULL);
+    deque->top = deque->bottom = 0;
+    uint64_t begin = count * w / numWorkers;
+    uint64_t end = count * (w + 1) / numWorkers;
+    if (end > begin)
+      deque->ranges[deque->bottom++] = (RANGE){ begin, end };
+  }
+
+  for (uint8_t w = 1; w < numWorkers; ++w) {
+    args[w] = (WORKER_ARGS){ &pool, w };
+    pthread_create(&pool.threads[w], NULL, WorkerThread, &args[w]);
+  }
+  args[0] = (WORKER_ARGS){ &pool, 0 };
+  WorkerThread(&args[0]);
+
+  for (uint8_t w = 1; w < numWorkers; ++w)
+    pthread_join(pool.threads[w], NULL);
+  for (uint8_t w = 0; w < numWorkers; ++w)
+    pthread_mutex_destroy(&pool.deques[w].lock);
+}
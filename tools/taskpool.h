@@ -0,0 +1,48 @@
+/*
+
+  taskpool.h
+
+  Copyright 2026 Matthew T. Pandina. All rights reserved.
+
+  This file is part of Tilt Puzzle.
+
+  Tilt Puzzle is free software: you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation, either version 3 of the
+  License, or (at your option) any later version.
+
+  Tilt Puzzle is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Tilt Puzzle.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef TASKPOOL_H
+#define TASKPOOL_H
+
+#include <stdint.h>
+
+// Work-stealing pool that runs a function over the index range [0, count) on several threads
+//
+// Each worker owns a deque of index ranges. It takes the newest range from its own deque and keeps
+// splitting it in half, pushing the upper half back, until the range is no bigger than the grain
+// size. A worker whose deque runs dry steals the oldest (and therefore largest) range from another
+// worker, so uneven work such as solving some boards taking far longer than others still keeps
+// every core busy until the end.
+
+// Called with a sub-range [begin, end) of the indices, worker is 0 ... numWorkers - 1
+typedef void (*TASKPOOL_FUNC)(void* context, uint8_t worker, uint64_t begin, uint64_t end);
+
+#define TASKPOOL_MAX_WORKERS 64
+
+// Returns the number of online CPUs, clamped to TASKPOOL_MAX_WORKERS
+uint8_t TaskPool_DefaultWorkers(void);
+
+// Returns once every index has been processed. Only one TaskPool_Run may be active at a time.
+void TaskPool_Run(uint8_t numWorkers, uint64_t count, uint64_t grain, TASKPOOL_FUNC func, void* context);
+
+#endif // TASKPOOL_H
@@ -0,0 +1,216 @@
+/*
+
+  tiltbatch.c
+
+  Copyright 2026 Matthew T. Pandina. All rights reserved.
+
+  This file is part of Tilt Puzzle.
+
+  Tilt Puzzle is free software: you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation, either version 3 of the
+  License, or (at your option) any later version.
+
+  Tilt Puzzle is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Tilt Puzzle.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include <pthread.h>
+
+#include "tiltbatch.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAVE_X86_KERNELS 1
+#endif
+
+static void ApplyBatchScalar(const uint32_t* stoppers, uint32_t* greens, uint32_t* blues, uint8_t* results, size_t count, TILT_DIRECTION direction)
+{
+  for (size_t i = 0; i < count; ++i) {
+    TILT_BOARD board = { stoppers[i], greens[i], blues[i], 0, 0 };
+    results[i] = Tilt_Apply(&board, direction);
+    greens[i] = board.greens;
+    blues[i] = board.blues;
+  }
+}
+
+// Turns the per-lane accumulators of a vector kernel into TILT_RESULT_* flags
+static inline uint8_t LaneResult(uint32_t moved, uint32_t greenFell, uint32_t blueFell, uint32_t greensLeft)
+{
+  uint8_t result = 0;
+  if (moved)
+    result |= TILT_RESULT_MOVED;
+  if (greenFell)
+    result |= TILT_RESULT_GREEN_FELL;
+  if (blueFell)
+    result |= TILT_RESULT_BLUE_FELL | TILT_RESULT_LOSE;
+  else if (!greensLeft)
+    result |= TILT_RESULT_WIN;
+  return result;
+}
+
+#ifdef HAVE_X86_KERNELS
+
+/*
+ * Both vector kernels run the same algorithm as TiltDirection in tiltengine.c, one board per
+ * 32-bit lane. Every lane keeps stepping until no lane has a piece that can move; lanes that
+ * finished early just step with an empty move mask, which leaves them unchanged.
+ */
+
+#define DEFINE_KERNEL(NAME, TARGET, VEC, WIDTH, LOAD, STORE, SET1, AND, ANDNOT, OR, SRLI, SLLI, CMPEQ, MOVEMASK, ZERO) \
+  static inline __attribute__((always_inline, target(TARGET))) VEC NAME##Forward(VEC v, const TILT_DIRECTION direction) \
+  {                                                                     \
+    switch (direction) {                                                \
+    case TILT_LEFT:                                                     \
+      return ANDNOT(SET1(TILT_MASK_COL4), SRLI(v, 1));                  \
+    case TILT_UP:                                                       \
+      return SRLI(v, TILT_BOARD_WIDTH);                                 \
+    case TILT_RIGHT:                                                    \
+      return AND(SLLI(v, 1), SET1(TILT_MASK_BOARD & ~TILT_MASK_COL0));  \
+    case TILT_DOWN:                                                     \
+    default:                                                            \
+      return AND(SLLI(v, TILT_BOARD_WIDTH), SET1(TILT_MASK_BOARD));     \
+    }                                                                   \
+  }                                                                     \
+                                                                        \
+  static inline __attribute__((always_inline, target(TARGET))) VEC NAME##Back(VEC v, const TILT_DIRECTION direction) \
+  {                                                                     \
+    switch (direction) {                                                \
+    case TILT_LEFT:                                                     \
+      return SLLI(v, 1);                                                \
+    case TILT_UP:                                                       \
+      return SLLI(v, TILT_BOARD_WIDTH);                                 \
+    case TILT_RIGHT:                                                    \
+      return SRLI(v, 1);                                                \
+    case TILT_DOWN:                                                     \
+    default:                                                            \
+      return SRLI(v, TILT_BOARD_WIDTH);                                 \
+    }                                                                   \
+  }                                                                     \
+                                                                        \
+  static inline __attribute__((always_inline, target(TARGET))) size_t NAME##Direction(const uint32_t* stoppers, uint32_t* greens, uint32_t* blues, \
+                                                                                       uint8_t* results, size_t count, const TILT_DIRECTION direction) \
+  {                                                                     \
+    const VEC hole = SET1(TILT_MASK_HOLE);                              \
+    const VEC zero = ZERO();                                            \
+    size_t i = 0;                                                       \
+    for (; i + WIDTH <= count; i += WIDTH) {                            \
+      const VEC s = LOAD((const VEC*)&stoppers[i]);                     \
+      VEC g = LOAD((const VEC*)&greens[i]);                             \
+      VEC b = LOAD((const VEC*)&blues[i]);                              \
+      VEC moved = zero, greenFell = zero, blueFell = zero;              \
+      for (;;) {                                                        \
+        VEC empty = ANDNOT(OR(s, OR(g, b)), SET1(TILT_MASK_BOARD));     \
+        VEC dst = AND(NAME##Forward(OR(g, b), direction), empty);       \
+        if (MOVEMASK(CMPEQ(dst, zero)) == (int)(UINT32_MAX >> (32 - WIDTH * 4))) \
+          break;                                                        \
+        VEC src = NAME##Back(dst, direction);                           \
+        g = OR(ANDNOT(src, g), NAME##Forward(AND(g, src), direction));  \
+        b = OR(ANDNOT(src, b), NAME##Forward(AND(b, src), direction));  \
+        moved = OR(moved, dst);                                         \
+        greenFell = OR(greenFell, AND(g, hole));                        \
+        blueFell = OR(blueFell, AND(b, hole));                          \
+        g = ANDNOT(hole, g);                                            \
+        b = ANDNOT(hole, b);                                            \
+      }                                                                 \
+      STORE((VEC*)&greens[i], g);                                       \
+      STORE((VEC*)&blues[i], b);                                        \
+      uint32_t m[WIDTH], gf[WIDTH], bf[WIDTH];                          \
+      STORE((VEC*)m, moved);                                            \
+      STORE((VEC*)gf, greenFell);                                       \
+      STORE((VEC*)bf, blueFell);                                        \
+      for (uint8_t lane = 0; lane < WIDTH; ++lane)                      \
+        results[i + lane] = LaneResult(m[lane], gf[lane], bf[lane], greens[i + lane]); \
+    }                                                                   \
+    return i;                                                           \
+  }                                                                     \
+                                                                        \
+  static __attribute__((target(TARGET))) void ApplyBatch##NAME(const uint32_t* stoppers, uint32_t* greens, uint32_t* blues, \
+                                                               uint8_t* results, size_t count, TILT_DIRECTION direction) \
+  {                                                                     \
+    size_t done;                                                        \
+    switch (direction) {                                                \
+    case TILT_LEFT:                                                     \
+      done = NAME##Direction(stoppers, greens, blues, results, count, TILT_LEFT); \
+      break;                                                            \
+    case TILT_UP:                                                       \
+      done = NAME##Direction(stoppers, greens, blues, results, count, TILT_UP); \
+      break;                                                            \
+    case TILT_RIGHT:                                                    \
+      done = NAME##Direction(stoppers, greens, blues, results, count, TILT_RIGHT); \
+      break;                                                            \
+    case TILT_DOWN:                                                     \
+    default:                                                            \
+      done = NAME##Direction(stoppers, greens, blues, results, count, TILT_DOWN); \
+      break;                                                            \
+    }                                                                   \
+    ApplyBatchScalar(stoppers + done, greens + done, blues + done, results + done, count - done, direction); \
+  }
+
+#define AVX2_SET1(x) _mm256_set1_epi32((int)(x))
+#define SSE2_SET1(x) _mm_set1_epi32((int)(x))
+
+DEFINE_KERNEL(Avx2, "avx2", __m256i, 8, _mm256_loadu_si256, _mm256_storeu_si256, AVX2_SET1, _mm256_and_si256, _mm256_andnot_si256,
+              _mm256_or_si256, _mm256_srli_epi32, _mm256_slli_epi32, _mm256_cmpeq_epi32, _mm256_movemask_epi8, _mm256_setzero_si256)
+
+DEFINE_KERNEL(Sse2, "sse2", __m128i, 4, _mm_loadu_si128, _mm_storeu_si128, SSE2_SET1, _mm_and_si128, _mm_andnot_si128,
+              _mm_or_si128, _mm_srli_epi32, _mm_slli_epi32, _mm_cmpeq_epi32, _mm_movemask_epi8, _mm_setzero_si128)
+
+#endif // HAVE_X86_KERNELS
+
+TILT_BATCH_KERNEL Tilt_BatchKernel(void)
+{
+#ifdef HAVE_X86_KERNELS
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2"))
+    return TILT_BATCH_AVX2;
+  if (__builtin_cpu_supports("sse2"))
+    return TILT_BATCH_SSE2;
+#endif
+  return TILT_BATCH_SCALAR;
+}
+
+const char* Tilt_BatchKernelName(TILT_BATCH_KERNEL kernel)
+{
+  static const char* names[] = { "scalar", "SSE2", "AVX2" };
+  return names[kernel];
+}
+
+void Tilt_ApplyBatchWith(TILT_BATCH_KERNEL kernel, const uint32_t* stoppers, uint32_t* greens, uint32_t* blues, uint8_t* results,
+                         size_t count, TILT_DIRECTION direction)
+{
+  switch (kernel) {
+#ifdef HAVE_X86_KERNELS
+  case TILT_BATCH_AVX2:
+    ApplyBatchAvx2(stoppers, greens, blues, results, count, direction);
+    break;
+  case TILT_BATCH_SSE2:
+    ApplyBatchSse2(stoppers, greens, blues, results, count, direction);
+    break;
+#endif
+  default:
+    ApplyBatchScalar(stoppers, greens, blues, results, count, direction);
+    break;
+  }
+}
+
+// Picked once for the whole process, callers on the worker threads can race to be first
+static pthread_once_t kernelOnce = PTHREAD_ONCE_INIT;
+static TILT_BATCH_KERNEL kernel;
+
+static void PickKernel(void)
+{
+  kernel = Tilt_BatchKernel();
+}
+
+void Tilt_ApplyBatch(const uint32_t* stoppers, uint32_t* greens, uint32_t* blues, uint8_t* results, size_t count, TILT_DIRECTION direction)
+{
+  pthread_once(&kernelOnce, PickKernel);
+  Tilt_ApplyBatchWith(kernel, stoppers, greens, blues, results, count, direction);
+}
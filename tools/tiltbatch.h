@@ -0,0 +1,68 @@
+/*
+
+  tiltbatch.h
+
+  Copyright 2026 Matthew T. Pandina. All rights reserved.
+
+  This file is part of Tilt Puzzle.
+
+  Tilt Puzzle is free software: you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation, either version 3 of the
+  License, or (at your option) any later version.
+
+  Tilt Puzzle is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Tilt Puzzle.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef TILTBATCH_H
+#define TILTBATCH_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "tiltengine.h"
+
+// Tilts many boards in the same direction at once, using AVX2 (8 boards per step) or SSE2 (4 boards
+// per step) when the CPU has them, and Tilt_Apply for whatever is left over
+//
+// The boards are stored as three parallel arrays (structure of arrays) so each vector load picks up
+// the same mask from consecutive boards. Stoppers never move, so that array is only read.
+// The boards have no gates, callers with gated boards use Tilt_Apply
+
+typedef enum {
+  TILT_BATCH_SCALAR = 0,
+  TILT_BATCH_SSE2 = 1,
+  TILT_BATCH_AVX2 = 2,
+} TILT_BATCH_KERNEL;
+
+// The kernel Tilt_ApplyBatch will use on this CPU
+TILT_BATCH_KERNEL Tilt_BatchKernel(void);
+
+const char* Tilt_BatchKernelName(TILT_BATCH_KERNEL kernel);
+
+/*
+ * Tilt_ApplyBatch
+ *
+ * Same as calling Tilt_Apply on boards 0 ... count-1, with the fastest kernel this CPU supports.
+ * Safe to call from several threads at once.
+ *
+ * stoppers, greens, blues [in, (out)]
+ *   The masks of each board, greens and blues are updated in place
+ *
+ * results [out]
+ *   The TILT_RESULT_* flags of each board
+ */
+void Tilt_ApplyBatch(const uint32_t* stoppers, uint32_t* greens, uint32_t* blues, uint8_t* results, size_t count, TILT_DIRECTION direction);
+
+// Tilt_ApplyBatch with a specific kernel, which must be supported by the CPU (for testing and benchmarking)
+void Tilt_ApplyBatchWith(TILT_BATCH_KERNEL kernel, const uint32_t* stoppers, uint32_t* greens, uint32_t* blues, uint8_t* results,
+                         size_t count, TILT_DIRECTION direction);
+
+#endif // TILTBATCH_H
@@ -0,0 +1,179 @@
+/*
+
+  tiltcache.c
+
+  Copyright 2026 Matthew T. Pandina. All rights reserved.
+
+  This file is part of Tilt Puzzle.
+
+  Tilt Puzzle is free software: you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation, either version 3 of the
+  License, or (at your option) any later version.
+
+  Tilt Puzzle is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Tilt Puzzle.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "tiltcache.h"
+
+#define MIN_LOG2_CAPACITY 10
+
+static inline uint32_t HashKey(uint64_t key, uint64_t gates, uint8_t log2Capacity)
+{
+  return (uint32_t)(((key ^ gates * UINT64_C(0xC2B2AE3D27D4EB4F)) * UINT64_C(0x9E3779B97F4A7C15)) >> (64 - log2Capacity));
+}
+
+static TILT_CACHE_ENTRY* FindSlot(const TILT_CACHE* cache, uint64_t key, uint64_t gates)
+{
+  uint32_t slot = HashKey(key, gates, cache->log2Capacity);
+  while ((cache->entries[slot].key != key || cache->entries[slot].gates != gates) && cache->entries[slot].key != TILT_SOLVER_EMPTY_KEY)
+    slot = (slot + 1) & cache->mask;
+  return &cache->entries[slot];
+}
+
+static bool Resize(TILT_CACHE* cache, uint8_t log2Capacity)
+{
+  TILT_CACHE_ENTRY* old = cache->entries;
+  uint32_t oldCapacity = old ? cache->mask + 1 : 0;
+
+  uint32_t capacity = UINT32_C(1) << log2Capacity;
+  cache->entries = malloc(capacity * sizeof(TILT_CACHE_ENTRY));
+  if (!cache->entries) {
+    cache->entries = old;
+    return false;
+  }
+  for (uint32_t i = 0; i < capacity; ++i)
+    cache->entries[i].key = TILT_SOLVER_EMPTY_KEY;
+  cache->mask = capacity - 1;
+  cache->log2Capacity = log2Capacity;
+
+  for (uint32_t i = 0; i < oldCapacity; ++i)
+    if (old[i].key != TILT_SOLVER_EMPTY_KEY)
+      *FindSlot(cache, old[i].key, old[i].gates) = old[i];
+  free(old);
+  return true;
+}
+
+bool TiltCache_Open(TILT_CACHE* cache, const char* path)
+{
+  memset(cache, 0, sizeof(TILT_CACHE));
+  cache->path = path;
+  if (!Resize(cache, MIN_LOG2_CAPACITY))
+    return false;
+
+  FILE* f = fopen(path, "rb");
+  if (!f)
+    return true;
+
+  TILT_CACHE_HEADER header;
+  if (fread(&header, sizeof(header), 1, f) == 1 && !memcmp(header.magic, TILT_CACHE_MAGIC, sizeof(header.magic))) {
+    // Keep the load factor under 1/2, with room to grow
+    uint8_t log2Capacity = MIN_LOG2_CAPACITY;
+    while ((UINT64_C(1) << log2Capacity) < header.entries * 2 && log2Capacity < 31)
+      ++log2Capacity;
+    if (log2Capacity > cache->log2Capacity && !Resize(cache, log2Capacity)) {
+      fclose(f);
+      return false;
+    }
+
+    TILT_CACHE_ENTRY entry;
+    for (uint64_t i = 0; i < header.entries && fread(&entry, sizeof(entry), 1, f) == 1; ++i) {
+      TILT_CACHE_ENTRY* slot = FindSlot(cache, entry.key, entry.gates);
+      if (slot->key == TILT_SOLVER_EMPTY_KEY && cache->count < cache->mask / 2) {
+        *slot = entry;
+        ++cache->count;
+      }
+    }
+  }
+  fclose(f);
+  return true;
+}
+
+bool TiltCache_Close(TILT_CACHE* cache)
+{
+  bool ok = true;
+  if (cache->dirty) {
+    // Write a new file and rename it over the old one, so an interrupted run can't leave a torn cache
+    char tmp[4096];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", cache->path);
+    FILE* f = fopen(tmp, "wb");
+    ok = (f != NULL);
+    if (ok) {
+      TILT_CACHE_HEADER header;
+      memcpy(header.magic, TILT_CACHE_MAGIC, sizeof(header.magic));
+      header.entries = cache->count;
+      ok = (fwrite(&header, sizeof(header), 1, f) == 1);
+      for (uint32_t i = 0; ok && i <= cache->mask; ++i)
+        if (cache->entries[i].key != TILT_SOLVER_EMPTY_KEY)
+          ok = (fwrite(&cache->entries[i], sizeof(TILT_CACHE_ENTRY), 1, f) == 1);
+      ok = (fclose(f) == 0) && ok;
+      ok = ok && (rename(tmp, cache->path) == 0);
+      if (!ok)
+        remove(tmp);
+    }
+  }
+  free(cache->entries);
+  cache->entries = NULL;
+  return ok;
+}
+
+bool TiltCache_Lookup(TILT_CACHE* cache, const TILT_BOARD* board, uint8_t* status, TILT_SOLUTION* solution)
+{
+  const TILT_CACHE_ENTRY* entry = FindSlot(cache, Tilt_PackKey(board), Tilt_PackGates(board));
+  if (entry->key == TILT_SOLVER_EMPTY_KEY) {
+    ++cache->misses;
+    return false;
+  }
+  ++cache->hits;
+  *status = entry->status;
+  solution->length = entry->length;
+  solution->states = entry->states;
+  for (uint8_t i = 0; i < entry->length; ++i)
+    solution->moves[i] = (entry->moves[i >> 2] >> ((i & 3) * 2)) & 3;
+  return true;
+}
+
+void TiltCache_Store(TILT_CACHE* cache, const TILT_BOARD* board, uint8_t status, const TILT_SOLUTION* solution)
+{
+  // Overflows depend on the table size the caller picked, so they are worth retrying next time
+  if (status == TILT_SOLVE_OVERFLOW)
+    return;
+  if (cache->count + 1 > cache->mask / 2 && !Resize(cache, cache->log2Capacity + 1))
+    return; // a cache that can't grow just stops caching
+
+  uint64_t key = Tilt_PackKey(board);
+  uint64_t gates = Tilt_PackGates(board);
+  TILT_CACHE_ENTRY* entry = FindSlot(cache, key, gates);
+  if (entry->key == TILT_SOLVER_EMPTY_KEY)
+    ++cache->count;
+  entry->key = key;
+  entry->gates = gates;
+  entry->states = solution->states;
+  entry->status = status;
+  entry->length = (status == TILT_SOLVE_OK) ? solution->length : 0;
+  memset(entry->moves, 0, sizeof(entry->moves));
+  for (uint8_t i = 0; i < entry->length; ++i)
+    entry->moves[i >> 2] |= solution->moves[i] << ((i & 3) * 2);
+  cache->dirty = true;
+}
+
+uint8_t TiltCache_Solve(TILT_CACHE* cache, TILT_SOLVER* solver, const TILT_BOARD* board, TILT_SOLUTION* solution)
+{
+  uint8_t status;
+  if (TiltCache_Lookup(cache, board, &status, solution))
+    return status;
+  status = TiltSolver_Solve(solver, board, solution);
+  TiltCache_Store(cache, board, status, solution);
+  return status;
+}
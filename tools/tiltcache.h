@@ -0,0 +1,81 @@
+/*
+
+  tiltcache.h
+
+  Copyright 2026 Matthew T. Pandina. All rights reserved.
+
+  This file is part of Tilt Puzzle.
+
+  Tilt Puzzle is free software: you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation, either version 3 of the
+  License, or (at your option) any later version.
+
+  Tilt Puzzle is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Tilt Puzzle.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef TILTCACHE_H
+#define TILTCACHE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "tiltengine.h"
+#include "tiltsolver.h"
+
+// Persistent cache of TiltSolver_Solve results, so re-checking a pack only solves the levels that changed
+//
+// The file is a TILT_CACHE_HEADER followed by one TILT_CACHE_ENTRY per board ever solved. Boards are
+// keyed by Tilt_PackKey and Tilt_PackGates, which between them encode all 25 cells and so can't collide.
+// The magic carries a version that must be bumped whenever the rules, the solver or the entries change,
+// making old files read as empty.
+
+#define TILT_CACHE_MAGIC "TILTSOL2"
+#define TILT_CACHE_MOVE_BYTES (TILT_MAX_SOLUTION_LENGTH / 4) // 2 bits per TILT_DIRECTION
+
+typedef struct {
+  char magic[8];
+  uint64_t entries;
+} __attribute__ ((packed)) TILT_CACHE_HEADER;
+
+typedef struct {
+  uint64_t key;   // Tilt_PackKey of the level, or TILT_SOLVER_EMPTY_KEY if the slot is free
+  uint64_t gates; // Tilt_PackGates of the level
+  uint32_t states;
+  uint8_t status; // TILT_SOLVE_*
+  uint8_t length;
+  uint8_t moves[TILT_CACHE_MOVE_BYTES]; // first move in the low bits of the first byte
+} __attribute__ ((packed)) TILT_CACHE_ENTRY;
+
+// The whole file lives in an open-addressing table while it is open, and is written back by TiltCache_Close
+typedef struct {
+  const char* path;
+  TILT_CACHE_ENTRY* entries;
+  uint32_t count;
+  uint32_t mask;
+  uint8_t log2Capacity;
+  bool dirty;
+  uint32_t hits;
+  uint32_t misses;
+} TILT_CACHE;
+
+// Loads the cache at path. A missing or stale file just gives an empty cache. Returns false if out of memory.
+bool TiltCache_Open(TILT_CACHE* cache, const char* path);
+
+// Writes the cache back if anything was added, then frees it. Returns false if the file couldn't be written.
+bool TiltCache_Close(TILT_CACHE* cache);
+
+bool TiltCache_Lookup(TILT_CACHE* cache, const TILT_BOARD* board, uint8_t* status, TILT_SOLUTION* solution);
+void TiltCache_Store(TILT_CACHE* cache, const TILT_BOARD* board, uint8_t status, const TILT_SOLUTION* solution);
+
+// Drop-in for TiltSolver_Solve that only runs the solver on boards the cache hasn't seen
+uint8_t TiltCache_Solve(TILT_CACHE* cache, TILT_SOLVER* solver, const TILT_BOARD* board, TILT_SOLUTION* solution);
+
+#endif // TILTCACHE_H
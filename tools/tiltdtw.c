@@ -0,0 +1,147 @@
+/*
+
+  tiltdtw.c
+
+  Copyright 2026 Matthew T. Pandina. All rights reserved.
+
+  This file is part of Tilt Puzzle.
+
+  Tilt Puzzle is free software: you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation, either version 3 of the
+  License, or (at your option) any later version.
+
+  Tilt Puzzle is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Tilt Puzzle.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "tiltdtw.h"
+
+#define MASK_SLOTS (TILT_MASK_BOARD & ~TILT_MASK_HOLE)
+
+static uint64_t binomial[TILT_DTW_NUM_SLOTS + 1][TILT_DTW_NUM_SLOTS + 1];
+static bool binomialReady;
+
+void TiltDtw_Init(void)
+{
+  if (binomialReady)
+    return;
+  for (uint8_t n = 0; n <= TILT_DTW_NUM_SLOTS; ++n) {
+    binomial[n][0] = 1;
+    for (uint8_t k = 1; k <= n; ++k)
+      binomial[n][k] = binomial[n - 1][k - 1] + (k < n ? binomial[n - 1][k] : 0);
+  }
+  binomialReady = true;
+}
+
+uint64_t TiltDtw_Binomial(uint8_t n, uint8_t k)
+{
+  TiltDtw_Init();
+  return (k <= n) ? binomial[n][k] : 0;
+}
+
+uint64_t TiltDtw_RankSubset(uint32_t subset, uint32_t universe)
+{
+  uint64_t rank = 0;
+  uint8_t position = 0;
+  uint8_t chosen = 0;
+  for (; universe; universe &= universe - 1, ++position) {
+    uint32_t bit = universe & -universe;
+    if (subset & bit)
+      rank += binomial[position][++chosen];
+  }
+  return rank;
+}
+
+uint32_t TiltDtw_UnrankSubset(uint64_t rank, uint8_t k, uint32_t universe)
+{
+  uint8_t cells[TILT_LEVEL_SIZE];
+  uint8_t n = 0;
+  for (; universe; universe &= universe - 1)
+    cells[n++] = (uint8_t)__builtin_ctz(universe);
+
+  uint32_t subset = 0;
+  for (uint8_t i = k; i > 0; --i) {
+    uint8_t position = i - 1;
+    while (position + 1 < n && binomial[position + 1][i] <= rank)
+      ++position;
+    rank -= binomial[position][i];
+    subset |= UINT32_C(1) << cells[position];
+    n = position;
+  }
+  return subset;
+}
+
+uint64_t TiltDtw_NumEntries(uint8_t stoppers, uint8_t greens, uint8_t blues)
+{
+  TiltDtw_Init();
+  if (stoppers + greens + blues > TILT_DTW_NUM_SLOTS)
+    return 0;
+  return binomial[TILT_DTW_NUM_SLOTS][stoppers] *
+    binomial[TILT_DTW_NUM_SLOTS - stoppers][greens] *
+    binomial[TILT_DTW_NUM_SLOTS - stoppers - greens][blues];
+}
+
+uint64_t TiltDtw_Index(const TILT_BOARD* board)
+{
+  uint8_t stoppers = Tilt_CountBits(board->stoppers);
+  uint8_t greens = Tilt_CountBits(board->greens);
+  uint8_t blues = Tilt_CountBits(board->blues);
+  uint32_t free = MASK_SLOTS & ~board->stoppers;
+
+  uint64_t index = TiltDtw_RankSubset(board->stoppers, MASK_SLOTS);
+  index = index * binomial[TILT_DTW_NUM_SLOTS - stoppers][greens] + TiltDtw_RankSubset(board->greens, free);
+  index = index * binomial[TILT_DTW_NUM_SLOTS - stoppers - greens][blues] + TiltDtw_RankSubset(board->blues, free & ~board->greens);
+  return index;
+}
+
+bool TiltDtw_Open(TILT_DTW* dtw, const char* path)
+{
+  TiltDtw_Init();
+  memset(dtw, 0, sizeof(TILT_DTW));
+
+  int fd = open(path, O_RDONLY);
+  if (fd < 0)
+    return false;
+  struct stat st;
+  if (fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(TILT_DTW_HEADER)) {
+    close(fd);
+    return false;
+  }
+  void* map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED)
+    return false;
+
+  const TILT_DTW_HEADER* header = map;
+  if (memcmp(header->magic, TILT_DTW_MAGIC, sizeof(header->magic)) != 0 ||
+      header->entries != TiltDtw_NumEntries(header->stoppers, header->greens, header->blues) ||
+      (size_t)st.st_size != sizeof(TILT_DTW_HEADER) + header->entries) {
+    munmap(map, st.st_size);
+    return false;
+  }
+
+  dtw->header = header;
+  dtw->table = (const uint8_t*)map + sizeof(TILT_DTW_HEADER);
+  dtw->size = st.st_size;
+  return true;
+}
+
+void TiltDtw_Close(TILT_DTW* dtw)
+{
+  if (dtw->header)
+    munmap((void*)dtw->header, dtw->size);
+  memset(dtw, 0, sizeof(TILT_DTW));
+}
@@ -0,0 +1,101 @@
+/*
+
+  tiltdtw.h
+
+  Copyright 2026 Matthew T. Pandina. All rights reserved.
+
+  This file is part of Tilt Puzzle.
+
+  Tilt Puzzle is free software: you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation, either version 3 of the
+  License, or (at your option) any later version.
+
+  Tilt Puzzle is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Tilt Puzzle.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef TILTDTW_H
+#define TILTDTW_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "tiltengine.h"
+
+// Distance-to-win tables, one file per combination of stopper, green and blue counts
+//
+// The file is a TILT_DTW_HEADER followed by one byte per board, so it can be memory-mapped and read
+// in place. A board's byte is found through a perfect hash: the combinatorial rank of the stoppers
+// among the 24 cells that are not the hole, then of the greens among the cells that are left, then
+// of the blues among the cells that are left after that.
+
+#define TILT_DTW_MAGIC "TILTDTW1"
+#define TILT_DTW_UNSOLVABLE 0xFF // no sequence of tilts wins from this board
+#define TILT_DTW_NUM_SLOTS (TILT_LEVEL_SIZE - 1)
+
+typedef struct {
+  char magic[8];
+  uint8_t stoppers;
+  uint8_t greens;
+  uint8_t blues;
+  uint8_t reserved[5];
+  uint64_t entries;
+} __attribute__ ((packed)) TILT_DTW_HEADER;
+
+typedef struct {
+  const TILT_DTW_HEADER* header;
+  const uint8_t* table;
+  size_t size; // of the whole mapping
+} TILT_DTW;
+
+// Builds the binomial table the functions below rely on. TiltDtw_Open and TiltDtw_NumEntries call it
+// for you, anything else must be preceded by at least one call (from a single thread).
+void TiltDtw_Init(void);
+
+// C(n, k) for n, k <= TILT_DTW_NUM_SLOTS
+uint64_t TiltDtw_Binomial(uint8_t n, uint8_t k);
+
+// Rank of subset among all subsets of universe with the same number of cells (combinatorial number system)
+uint64_t TiltDtw_RankSubset(uint32_t subset, uint32_t universe);
+
+// The inverse of TiltDtw_RankSubset, for subsets of k cells
+uint32_t TiltDtw_UnrankSubset(uint64_t rank, uint8_t k, uint32_t universe);
+
+// Number of boards with the given counts, which is also the number of entries in their table
+uint64_t TiltDtw_NumEntries(uint8_t stoppers, uint8_t greens, uint8_t blues);
+
+// Perfect hash of a board among all boards with the same counts
+uint64_t TiltDtw_Index(const TILT_BOARD* board);
+
+// Memory-maps a table written by tools/retrograde, returns false if it can't be opened or is malformed
+bool TiltDtw_Open(TILT_DTW* dtw, const char* path);
+void TiltDtw_Close(TILT_DTW* dtw);
+
+/*
+ * TiltDtw_Lookup
+ *
+ * Returns the number of tilts an optimal solution from board needs, 0 if it is already
+ * won, or TILT_DTW_UNSOLVABLE. The board must have the piece counts the table was built
+ * for (see TiltDtw_Matches).
+ */
+static inline uint8_t TiltDtw_Lookup(const TILT_DTW* dtw, const TILT_BOARD* board)
+{
+  return dtw->table[TiltDtw_Index(board)];
+}
+
+static inline bool TiltDtw_Matches(const TILT_DTW* dtw, const TILT_BOARD* board)
+{
+  return Tilt_CountBits(board->stoppers) == dtw->header->stoppers &&
+    Tilt_CountBits(board->greens) == dtw->header->greens &&
+    Tilt_CountBits(board->blues) == dtw->header->blues;
+}
+
+#endif // TILTDTW_H
@@ -0,0 +1,226 @@
+/*
+
+  tiltengine.c
+
+  Copyright 2026 Matthew T. Pandina. All rights reserved.
+
+  This file is part of Tilt Puzzle.
+
+  Tilt Puzzle is free software: you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation, either version 3 of the
+  License, or (at your option) any later version.
+
+  Tilt Puzzle is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Tilt Puzzle.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "tiltengine.h"
+
+void Tilt_FromCells(TILT_BOARD* board, const uint8_t* cells)
+{
+  board->stoppers = board->greens = board->blues = board->gatesH = board->gatesV = 0;
+  for (uint8_t i = 0; i < TILT_LEVEL_SIZE; ++i) {
+    uint32_t bit = UINT32_C(1) << i;
+    switch (cells[i]) {
+    case TILT_CELL_STOPPER:
+      board->stoppers |= bit;
+      break;
+    case TILT_CELL_GREEN:
+      board->greens |= bit;
+      break;
+    case TILT_CELL_BLUE:
+      board->blues |= bit;
+      break;
+    case TILT_CELL_GATE_H:
+      board->gatesH |= bit;
+      break;
+    case TILT_CELL_GATE_V:
+      board->gatesV |= bit;
+      break;
+    }
+  }
+}
+
+void Tilt_ToCells(const TILT_BOARD* board, uint8_t* cells)
+{
+  for (uint8_t i = 0; i < TILT_LEVEL_SIZE; ++i) {
+    uint32_t bit = UINT32_C(1) << i;
+    if (board->stoppers & bit)
+      cells[i] = TILT_CELL_STOPPER;
+    else if (board->greens & bit)
+      cells[i] = TILT_CELL_GREEN;
+    else if (board->blues & bit)
+      cells[i] = TILT_CELL_BLUE;
+    else if (board->gatesH & bit)
+      cells[i] = TILT_CELL_GATE_H;
+    else if (board->gatesV & bit)
+      cells[i] = TILT_CELL_GATE_V;
+    else
+      cells[i] = TILT_CELL_EMPTY;
+  }
+}
+
+// symmetryTable[s][chunk][byte] is where the 8 cells (chunk * 8 ... chunk * 8 + 7) selected by byte end up under symmetry s
+static uint32_t symmetryTable[TILT_NUM_SYMMETRIES][4][256];
+
+void Tilt_InitSymmetry(void)
+{
+  for (uint8_t s = 0; s < TILT_NUM_SYMMETRIES; ++s)
+    for (uint8_t chunk = 0; chunk < 4; ++chunk)
+      for (uint16_t byte = 0; byte < 256; ++byte) {
+        uint32_t out = 0;
+        for (uint8_t bit = 0; bit < 8; ++bit) {
+          uint8_t i = chunk * 8 + bit;
+          if (!(byte & (1 << bit)) || i >= TILT_LEVEL_SIZE)
+            continue;
+          uint8_t x = i % TILT_BOARD_WIDTH;
+          uint8_t y = i / TILT_BOARD_WIDTH;
+          // Optionally mirror, then rotate by 90 degrees (s & 3) times
+          if (s & 4)
+            x = TILT_BOARD_WIDTH - 1 - x;
+          for (uint8_t r = 0; r < (s & 3); ++r) {
+            uint8_t t = x;
+            x = TILT_BOARD_HEIGHT - 1 - y;
+            y = t;
+          }
+          out |= TILT_BIT(x, y);
+        }
+        symmetryTable[s][chunk][byte] = out;
+      }
+}
+
+uint32_t Tilt_TransformMask(uint32_t mask, uint8_t symmetry)
+{
+  const uint32_t (*table)[256] = symmetryTable[symmetry];
+  return table[0][mask & 0xFF] | table[1][(mask >> 8) & 0xFF] | table[2][(mask >> 16) & 0xFF] | table[3][mask >> 24];
+}
+
+void Tilt_TransformBoard(TILT_BOARD* out, const TILT_BOARD* board, uint8_t symmetry)
+{
+  out->stoppers = Tilt_TransformMask(board->stoppers, symmetry);
+  out->greens = Tilt_TransformMask(board->greens, symmetry);
+  out->blues = Tilt_TransformMask(board->blues, symmetry);
+  // A quarter turn makes a gate across one axis a gate across the other
+  uint32_t gatesH = Tilt_TransformMask(board->gatesH, symmetry);
+  uint32_t gatesV = Tilt_TransformMask(board->gatesV, symmetry);
+  out->gatesH = (symmetry & 1) ? gatesV : gatesH;
+  out->gatesV = (symmetry & 1) ? gatesH : gatesV;
+}
+
+uint64_t Tilt_CanonicalKey(const TILT_BOARD* board, uint64_t* gates)
+{
+  uint64_t best = Tilt_PackKey(board);
+  uint64_t bestGates = Tilt_PackGates(board);
+  for (uint8_t s = 1; s < TILT_NUM_SYMMETRIES; ++s) {
+    TILT_BOARD t;
+    Tilt_TransformBoard(&t, board, s);
+    uint64_t key = Tilt_PackKey(&t);
+    uint64_t tGates = Tilt_PackGates(&t);
+    if (key < best || (key == best && tGates < bestGates)) {
+      best = key;
+      bestGates = tGates;
+    }
+  }
+  if (gates)
+    *gates = bestGates;
+  return best;
+}
+
+// Moves every cell in the mask one step in a direction, dropping anything that would leave the board
+static inline __attribute__((always_inline)) uint32_t ShiftForward(uint32_t mask, TILT_DIRECTION direction)
+{
+  switch (direction) {
+  case TILT_LEFT:
+    return (mask >> 1) & ~TILT_MASK_COL4;
+  case TILT_UP:
+    return mask >> TILT_BOARD_WIDTH;
+  case TILT_RIGHT:
+    return (mask << 1) & ~TILT_MASK_COL0 & TILT_MASK_BOARD;
+  case TILT_DOWN:
+  default:
+    return (mask << TILT_BOARD_WIDTH) & TILT_MASK_BOARD;
+  }
+}
+
+// The inverse of ShiftForward, for masks that came out of ShiftForward
+static inline __attribute__((always_inline)) uint32_t ShiftBack(uint32_t mask, TILT_DIRECTION direction)
+{
+  switch (direction) {
+  case TILT_LEFT:
+    return mask << 1;
+  case TILT_UP:
+    return mask << TILT_BOARD_WIDTH;
+  case TILT_RIGHT:
+    return mask >> 1;
+  case TILT_DOWN:
+  default:
+    return mask >> TILT_BOARD_WIDTH;
+  }
+}
+
+/*
+ * Instead of walking each piece toward the wall and counting the G's and B's in its way, every
+ * piece that has an empty cell in front of it advances one step at a time until nothing can
+ * move. Pieces that step onto the hole are removed, which is the same as TiltBoard* breaking
+ * out of its walk when the next cell is the hole: anything queued up behind it keeps sliding
+ * and falls in as well, and a stopper on the far side of the hole is never reached. The
+ * resulting stacks against stoppers and walls are identical to xEnd +/- numGreenBlueSeen.
+ */
+static inline __attribute__((always_inline)) uint8_t TiltDirection(TILT_BOARD* board, const TILT_DIRECTION direction)
+{
+  uint32_t greens = board->greens;
+  uint32_t blues = board->blues;
+  uint8_t result = 0;
+
+  // Gates across this axis stop pieces like stoppers do, and hold on to any piece already on them
+  const uint32_t walls = board->stoppers | ((direction == TILT_LEFT || direction == TILT_RIGHT) ? board->gatesH : board->gatesV);
+
+  for (;;) {
+    uint32_t empty = ~(walls | greens | blues);
+    uint32_t dst = ShiftForward((greens | blues) & ~walls, direction) & empty;
+    if (!dst)
+      break;
+    uint32_t src = ShiftBack(dst, direction);
+    greens = (greens & ~src) | ShiftForward(greens & src, direction);
+    blues = (blues & ~src) | ShiftForward(blues & src, direction);
+
+    if (greens & TILT_MASK_HOLE)
+      result |= TILT_RESULT_GREEN_FELL;
+    if (blues & TILT_MASK_HOLE)
+      result |= TILT_RESULT_BLUE_FELL;
+    greens &= ~TILT_MASK_HOLE;
+    blues &= ~TILT_MASK_HOLE;
+    result |= TILT_RESULT_MOVED;
+  }
+
+  board->greens = greens;
+  board->blues = blues;
+
+  if (result & TILT_RESULT_BLUE_FELL)
+    result |= TILT_RESULT_LOSE;
+  else if (!greens)
+    result |= TILT_RESULT_WIN;
+  return result;
+}
+
+uint8_t Tilt_Apply(TILT_BOARD* board, TILT_DIRECTION direction)
+{
+  switch (direction) {
+  case TILT_LEFT:
+    return TiltDirection(board, TILT_LEFT);
+  case TILT_UP:
+    return TiltDirection(board, TILT_UP);
+  case TILT_RIGHT:
+    return TiltDirection(board, TILT_RIGHT);
+  case TILT_DOWN:
+  default:
+    return TiltDirection(board, TILT_DOWN);
+  }
+}
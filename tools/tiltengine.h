@@ -0,0 +1,175 @@
+/*
+
+  tiltengine.h
+
+  Copyright 2026 Matthew T. Pandina. All rights reserved.
+
+  This file is part of Tilt Puzzle.
+
+  Tilt Puzzle is free software: you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation, either version 3 of the
+  License, or (at your option) any later version.
+
+  Tilt Puzzle is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Tilt Puzzle.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef TILTENGINE_H
+#define TILTENGINE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Host-side implementation of the rules in TiltBoardLeft/Up/Right/Down + UpdateBoardAfterMove (tilt.c)
+
+#define TILT_BOARD_WIDTH 5
+#define TILT_BOARD_HEIGHT 5
+#define TILT_LEVEL_SIZE (TILT_BOARD_WIDTH * TILT_BOARD_HEIGHT)
+#define TILT_HOLE_X 2
+#define TILT_HOLE_Y 2
+#define TILT_MAX_MOVABLE_PIECES 10
+
+// Cell values, identical to the S/G/B/H/V defines in levels.h
+#define TILT_CELL_EMPTY 0
+#define TILT_CELL_STOPPER 1
+#define TILT_CELL_GREEN 2
+#define TILT_CELL_BLUE 3
+#define TILT_CELL_GATE_H 4 // stops pieces moving LEFT or RIGHT, they still slide through it UP or DOWN
+#define TILT_CELL_GATE_V 5 // stops pieces moving UP or DOWN
+
+// Bit (y * TILT_BOARD_WIDTH + x) of each mask is the cell at (x, y)
+#define TILT_BIT(x, y) (UINT32_C(1) << ((y) * TILT_BOARD_WIDTH + (x)))
+#define TILT_MASK_BOARD ((UINT32_C(1) << TILT_LEVEL_SIZE) - 1)
+#define TILT_MASK_HOLE TILT_BIT(TILT_HOLE_X, TILT_HOLE_Y)
+#define TILT_MASK_COL0 (TILT_BIT(0, 0) | TILT_BIT(0, 1) | TILT_BIT(0, 2) | TILT_BIT(0, 3) | TILT_BIT(0, 4))
+#define TILT_MASK_COL4 (TILT_MASK_COL0 << (TILT_BOARD_WIDTH - 1))
+
+// The order matches the 2 bits per move used to encode solutions
+typedef enum {
+  TILT_LEFT = 0,
+  TILT_UP = 1,
+  TILT_RIGHT = 2,
+  TILT_DOWN = 3,
+} TILT_DIRECTION;
+
+#define TILT_NUM_DIRECTIONS 4
+
+// Bit flags returned by Tilt_Apply
+#define TILT_RESULT_MOVED (1 << 0)       // at least one piece changed position
+#define TILT_RESULT_GREEN_FELL (1 << 1)  // at least one G fell down the hole
+#define TILT_RESULT_BLUE_FELL (1 << 2)   // at least one B fell down the hole
+#define TILT_RESULT_WIN (1 << 3)         // youWin after UpdateBoardAfterMove
+#define TILT_RESULT_LOSE (1 << 4)        // youLose after TiltBoard*
+
+// Gates never move, and a piece on one can't leave it along the axis it blocks. They are left out of
+// Tilt_PackKey, so code that unpacks keys has to copy them over from the board it started with.
+typedef struct {
+  uint32_t stoppers;
+  uint32_t greens;
+  uint32_t blues;
+  uint32_t gatesH; // TILT_CELL_GATE_H
+  uint32_t gatesV; // TILT_CELL_GATE_V
+} TILT_BOARD;
+
+// The 8 rotations and reflections of the board, all of which keep the hole in place
+#define TILT_NUM_SYMMETRIES 8
+
+// Converts a 25 byte level (as stored in levelData) to per-kind bitmasks
+void Tilt_FromCells(TILT_BOARD* board, const uint8_t* cells);
+
+// Converts per-kind bitmasks back to a 25 byte level
+void Tilt_ToCells(const TILT_BOARD* board, uint8_t* cells);
+
+/*
+ * Tilt_Apply
+ *
+ * Tilts the board in a direction, updating it in place
+ *
+ * board [in, out]
+ *   The board to tilt. Like the game, it must not contain more than
+ *   TILT_MAX_MOVABLE_PIECES G's and B's, and nothing may start on the hole.
+ *
+ * direction [in]
+ *   The direction to tilt the board
+ *
+ * Returns:
+ *   A combination of TILT_RESULT_* flags
+ */
+uint8_t Tilt_Apply(TILT_BOARD* board, TILT_DIRECTION direction);
+
+// Spreads the low 25 bits of a mask out to the even bits of a 64-bit value
+static inline uint64_t Tilt_SpreadBits(uint32_t mask)
+{
+  uint64_t v = mask;
+  v = (v | (v << 16)) & UINT64_C(0x0000FFFF0000FFFF);
+  v = (v | (v << 8)) & UINT64_C(0x00FF00FF00FF00FF);
+  v = (v | (v << 4)) & UINT64_C(0x0F0F0F0F0F0F0F0F);
+  v = (v | (v << 2)) & UINT64_C(0x3333333333333333);
+  v = (v | (v << 1)) & UINT64_C(0x5555555555555555);
+  return v;
+}
+
+// The inverse of Tilt_SpreadBits
+static inline uint32_t Tilt_GatherBits(uint64_t v)
+{
+  v &= UINT64_C(0x5555555555555555);
+  v = (v | (v >> 1)) & UINT64_C(0x3333333333333333);
+  v = (v | (v >> 2)) & UINT64_C(0x0F0F0F0F0F0F0F0F);
+  v = (v | (v >> 4)) & UINT64_C(0x00FF00FF00FF00FF);
+  v = (v | (v >> 8)) & UINT64_C(0x0000FFFF0000FFFF);
+  v = (v | (v >> 16)) & UINT64_C(0x00000000FFFFFFFF);
+  return (uint32_t)v;
+}
+
+// Packs a board into 2 bits per cell (cell i in bits 2i and 2i+1), holding the same values as levelData
+static inline uint64_t Tilt_PackKey(const TILT_BOARD* board)
+{
+  return Tilt_SpreadBits(board->stoppers | board->blues) | (Tilt_SpreadBits(board->greens | board->blues) << 1);
+}
+
+// The gates Tilt_PackKey leaves out, gatesH in the low word and gatesV in the high word
+static inline uint64_t Tilt_PackGates(const TILT_BOARD* board)
+{
+  return board->gatesH | ((uint64_t)board->gatesV << 32);
+}
+
+static inline void Tilt_UnpackKey(TILT_BOARD* board, uint64_t key)
+{
+  uint32_t lo = Tilt_GatherBits(key);
+  uint32_t hi = Tilt_GatherBits(key >> 1);
+  board->stoppers = lo & ~hi;
+  board->greens = hi & ~lo;
+  board->blues = lo & hi;
+}
+
+// Builds the bit-permutation tables used by the symmetry functions below, call once before using them
+void Tilt_InitSymmetry(void);
+
+// Rotates/reflects a 25-bit cell mask, symmetry 0 is the identity
+uint32_t Tilt_TransformMask(uint32_t mask, uint8_t symmetry);
+
+void Tilt_TransformBoard(TILT_BOARD* out, const TILT_BOARD* board, uint8_t symmetry);
+
+// Returns the smallest Tilt_PackKey over all 8 symmetries, so boards that are the same under rotation or reflection share a key.
+// The Tilt_PackGates of that same symmetry goes in gates (if it isn't NULL), and boards are only the same if both words match.
+// Ties between symmetries go to the smallest gates.
+uint64_t Tilt_CanonicalKey(const TILT_BOARD* board, uint64_t* gates);
+
+static inline uint8_t Tilt_CountBits(uint32_t mask)
+{
+  return (uint8_t)__builtin_popcount(mask);
+}
+
+static inline char Tilt_DirectionChar(TILT_DIRECTION direction)
+{
+  return "LURD"[direction & 3];
+}
+
+#endif // TILTENGINE_H
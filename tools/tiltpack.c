@@ -0,0 +1,150 @@
+/*
+
+  tiltpack.c
+
+  Copyright 2026 Matthew T. Pandina. All rights reserved.
+
+  This file is part of Tilt Puzzle.
+
+  Tilt Puzzle is free software: you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation, either version 3 of the
+  License, or (at your option) any later version.
+
+  Tilt Puzzle is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Tilt Puzzle.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "tiltpack.h"
+
+bool TiltPack_Open(TILT_PACK* pack, const char* path)
+{
+  memset(pack, 0, sizeof(TILT_PACK));
+  pack->line = 1;
+
+  int fd = open(path, O_RDONLY);
+  if (fd < 0)
+    return false;
+  struct stat st;
+  if (fstat(fd, &st) < 0) {
+    close(fd);
+    return false;
+  }
+  if (st.st_size == 0) { // mmap refuses empty files, but an empty pack is just a pack with no levels
+    close(fd);
+    return true;
+  }
+  void* map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED)
+    return false;
+  madvise(map, st.st_size, MADV_SEQUENTIAL);
+
+  pack->data = map;
+  pack->size = st.st_size;
+  return true;
+}
+
+void TiltPack_Close(TILT_PACK* pack)
+{
+  if (pack->data)
+    munmap((void*)pack->data, pack->size);
+  memset(pack, 0, sizeof(TILT_PACK));
+}
+
+// Advances past whitespace and comments, keeping track of the line number
+static void SkipSpace(TILT_PACK* pack)
+{
+  while (pack->pos < pack->size) {
+    char c = pack->data[pack->pos];
+    if (c == '\n') {
+      ++pack->line;
+      ++pack->pos;
+    } else if (c == ' ' || c == '\t' || c == '\r' || c == ',') {
+      ++pack->pos;
+    } else if (c == '/' && pack->pos + 1 < pack->size && pack->data[pack->pos + 1] == '/') {
+      while (pack->pos < pack->size && pack->data[pack->pos] != '\n')
+        ++pack->pos;
+    } else if (c == '/' && pack->pos + 1 < pack->size && pack->data[pack->pos + 1] == '*') {
+      pack->pos += 2;
+      while (pack->pos + 1 < pack->size && !(pack->data[pack->pos] == '*' && pack->data[pack->pos + 1] == '/')) {
+        if (pack->data[pack->pos] == '\n')
+          ++pack->line;
+        ++pack->pos;
+      }
+      pack->pos += 2;
+    } else {
+      return;
+    }
+  }
+}
+
+static inline bool IsTokenChar(char c)
+{
+  return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+uint8_t TiltPack_Next(TILT_PACK* pack, uint8_t* cells, uint32_t* line)
+{
+  if (!pack->inArray) {
+    const char* brace = pack->data ? memchr(pack->data, '{', pack->size) : NULL;
+    if (!brace)
+      return TILT_PACK_END;
+    for (const char* p = pack->data; p < brace; ++p)
+      if (*p == '\n')
+        ++pack->line;
+    pack->pos = brace - pack->data + 1;
+    pack->inArray = true;
+  }
+
+  for (uint8_t i = 0; i < TILT_LEVEL_SIZE; ++i) {
+    SkipSpace(pack);
+    if (pack->pos >= pack->size || pack->data[pack->pos] == '}')
+      return (i == 0) ? TILT_PACK_END : TILT_PACK_TRUNCATED;
+    if (i == 0)
+      *line = pack->line;
+
+    size_t start = pack->pos;
+    while (pack->pos < pack->size && IsTokenChar(pack->data[pack->pos]))
+      ++pack->pos;
+    if (pack->pos == start) // punctuation we don't understand is a bad cell on its own
+      ++pack->pos;
+
+    uint8_t cell = TILT_CELL_INVALID;
+    if (pack->pos - start == 1)
+      switch (pack->data[start]) {
+      case '0':
+        cell = TILT_CELL_EMPTY;
+        break;
+      case 'S':
+        cell = TILT_CELL_STOPPER;
+        break;
+      case 'G':
+        cell = TILT_CELL_GREEN;
+        break;
+      case 'B':
+        cell = TILT_CELL_BLUE;
+        break;
+      case 'H':
+        cell = TILT_CELL_GATE_H;
+        break;
+      case 'V':
+        cell = TILT_CELL_GATE_V;
+        break;
+      }
+    cells[i] = cell;
+  }
+  return TILT_PACK_OK;
+}
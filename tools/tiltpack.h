@@ -0,0 +1,73 @@
+/*
+
+  tiltpack.h
+
+  Copyright 2026 Matthew T. Pandina. All rights reserved.
+
+  This file is part of Tilt Puzzle.
+
+  Tilt Puzzle is free software: you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation, either version 3 of the
+  License, or (at your option) any later version.
+
+  Tilt Puzzle is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Tilt Puzzle.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef TILTPACK_H
+#define TILTPACK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "tiltengine.h"
+
+// Streams the levels out of a level pack written in the same format as levels.h
+//
+// The file is memory-mapped and read front to back, so memory use does not grow with the size of
+// the pack. Everything up to the first '{' is skipped, then every comma-separated cell up to the
+// matching '}' is read, 25 at a time. Comments are ignored.
+
+#define TILT_CELL_INVALID 0xFF // anything but 0, S, G, B, H or V
+
+// Return values of TiltPack_Next
+#define TILT_PACK_OK 0
+#define TILT_PACK_END 1
+#define TILT_PACK_TRUNCATED 2 // the pack ended partway through a level
+
+typedef struct {
+  const char* data;
+  size_t size;
+  size_t pos;
+  uint32_t line; // 1-based line of pos
+  bool inArray;
+} TILT_PACK;
+
+bool TiltPack_Open(TILT_PACK* pack, const char* path);
+void TiltPack_Close(TILT_PACK* pack);
+
+/*
+ * TiltPack_Next
+ *
+ * Reads the next level
+ *
+ * cells [out]
+ *   The 25 cells of the level, TILT_CELL_INVALID for any cell that isn't 0, S, G, B, H or V
+ *
+ * line [out]
+ *   The line the level starts on
+ *
+ * Returns:
+ *   TILT_PACK_OK, TILT_PACK_END or TILT_PACK_TRUNCATED
+ */
+uint8_t TiltPack_Next(TILT_PACK* pack, uint8_t* cells, uint32_t* line);
+
+#endif // TILTPACK_H
@@ -0,0 +1,280 @@
+/*
+
+  tiltsolver.c
+
+  Copyright 2026 Matthew T. Pandina. All rights reserved.
+
+  This file is part of Tilt Puzzle.
+
+  Tilt Puzzle is free software: you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation, either version 3 of the
+  License, or (at your option) any later version.
+
+  Tilt Puzzle is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Tilt Puzzle.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "tiltsolver.h"
+
+bool TiltSolver_Init(TILT_SOLVER* solver, uint8_t log2Capacity)
+{
+  solver->log2Capacity = log2Capacity;
+  solver->capacity = UINT32_C(1) << log2Capacity;
+  solver->mask = solver->capacity - 1;
+  solver->nodes = malloc(solver->capacity * sizeof(TILT_NODE));
+  solver->queue = malloc(solver->capacity * sizeof(uint32_t));
+  if (!solver->nodes || !solver->queue) {
+    TiltSolver_Free(solver);
+    return false;
+  }
+  for (uint32_t i = 0; i < solver->capacity; ++i)
+    solver->nodes[i].key = TILT_SOLVER_EMPTY_KEY;
+  return true;
+}
+
+void TiltSolver_Free(TILT_SOLVER* solver)
+{
+  free(solver->nodes);
+  free(solver->queue);
+  solver->nodes = NULL;
+  solver->queue = NULL;
+}
+
+static inline uint32_t HashKey(uint64_t key, uint8_t log2Capacity)
+{
+  return (uint32_t)((key * UINT64_C(0x9E3779B97F4A7C15)) >> (64 - log2Capacity));
+}
+
+// Returns the slot holding key, inserting it if needed. *inserted tells which happened.
+static inline uint32_t FindOrInsert(TILT_SOLVER* solver, uint64_t key, bool* inserted)
+{
+  uint32_t slot = HashKey(key, solver->log2Capacity);
+  for (;;) {
+    TILT_NODE* node = &solver->nodes[slot];
+    if (node->key == key) {
+      *inserted = false;
+      return slot;
+    }
+    if (node->key == TILT_SOLVER_EMPTY_KEY) {
+      node->key = key;
+      *inserted = true;
+      return slot;
+    }
+    slot = (slot + 1) & solver->mask;
+  }
+}
+
+static void ExtractSolution(const TILT_SOLVER* solver, uint32_t slot, uint8_t lastMove, TILT_SOLUTION* solution)
+{
+  uint8_t length = solver->nodes[slot].depth + 1;
+  solution->length = length;
+  solution->moves[--length] = lastMove;
+  while (length > 0) {
+    solution->moves[--length] = solver->nodes[slot].move;
+    slot = solver->nodes[slot].parent;
+  }
+}
+
+uint8_t TiltSolver_Solve(TILT_SOLVER* solver, const TILT_BOARD* board, TILT_SOLUTION* solution)
+{
+  solution->length = 0;
+  solution->states = 1;
+  if (!board->greens)
+    return TILT_SOLVE_OK;
+
+  uint32_t head = 0;
+  uint32_t tail = 0;
+  // Keep the load factor under 3/4 so probe sequences stay short
+  const uint32_t limit = solver->capacity - (solver->capacity >> 2);
+  uint8_t status = TILT_SOLVE_UNSOLVABLE;
+
+  bool inserted;
+  uint32_t root = FindOrInsert(solver, Tilt_PackKey(board), &inserted);
+  solver->nodes[root].parent = root;
+  solver->nodes[root].depth = 0;
+  solver->queue[tail++] = root;
+
+  while (head < tail) {
+    uint32_t slot = solver->queue[head++];
+    TILT_BOARD current = *board; // keeps the gates, which aren't in the key
+    Tilt_UnpackKey(&current, solver->nodes[slot].key);
+
+    for (uint8_t direction = 0; direction < TILT_NUM_DIRECTIONS; ++direction) {
+      TILT_BOARD next = current;
+      uint8_t result = Tilt_Apply(&next, (TILT_DIRECTION)direction);
+      if (!(result & TILT_RESULT_MOVED) || (result & TILT_RESULT_LOSE))
+        continue;
+
+      if (result & TILT_RESULT_WIN) {
+        if (solver->nodes[slot].depth + 1 > TILT_MAX_SOLUTION_LENGTH) {
+          status = TILT_SOLVE_OVERFLOW;
+          goto done;
+        }
+        ExtractSolution(solver, slot, direction, solution);
+        status = TILT_SOLVE_OK;
+        goto done;
+      }
+
+      uint32_t child = FindOrInsert(solver, Tilt_PackKey(&next), &inserted);
+      if (!inserted)
+        continue;
+      solver->nodes[child].parent = slot;
+      solver->nodes[child].move = direction;
+      solver->nodes[child].depth = solver->nodes[slot].depth + 1;
+      solver->queue[tail++] = child;
+      if (tail >= limit) {
+        status = TILT_SOLVE_OVERFLOW;
+        goto done;
+      }
+    }
+  }
+
+ done:
+  solution->states = tail;
+  // Only the slots we touched need to be freed, so memory use stays flat and clearing stays cheap
+  for (uint32_t i = 0; i < tail; ++i)
+    solver->nodes[solver->queue[i]].key = TILT_SOLVER_EMPTY_KEY;
+  return status;
+}
+
+bool TiltGraph_Init(TILT_GRAPH* graph, uint32_t capacity)
+{
+  graph->capacity = capacity;
+  graph->numStates = 0;
+  graph->next = malloc(capacity * sizeof(*graph->next));
+  graph->dist = malloc(capacity);
+  graph->greens = malloc(capacity);
+  if (!graph->next || !graph->dist || !graph->greens) {
+    TiltGraph_Free(graph);
+    return false;
+  }
+  return true;
+}
+
+void TiltGraph_Free(TILT_GRAPH* graph)
+{
+  free(graph->next);
+  free(graph->dist);
+  free(graph->greens);
+  graph->next = NULL;
+  graph->dist = NULL;
+  graph->greens = NULL;
+}
+
+uint8_t TiltSolver_BuildGraph(TILT_SOLVER* solver, const TILT_BOARD* board, TILT_GRAPH* graph)
+{
+  uint32_t head = 0;
+  uint32_t tail = 0;
+  const uint32_t limit = solver->capacity - (solver->capacity >> 2);
+  uint8_t status = TILT_SOLVE_OK;
+
+  // Unlike TiltSolver_Solve, a node's parent field holds its own state number (its position in the queue)
+  bool inserted;
+  uint32_t root = FindOrInsert(solver, Tilt_PackKey(board), &inserted);
+  solver->nodes[root].parent = 0;
+  solver->queue[tail++] = root;
+
+  while (head < tail) {
+    uint32_t state = head;
+    uint32_t slot = solver->queue[head++];
+    TILT_BOARD current = *board; // keeps the gates, which aren't in the key
+    Tilt_UnpackKey(&current, solver->nodes[slot].key);
+    graph->greens[state] = Tilt_CountBits(current.greens);
+
+    for (uint8_t direction = 0; direction < TILT_NUM_DIRECTIONS; ++direction) {
+      uint32_t next = TILT_GRAPH_NONE;
+      if (current.greens) { // won boards are not expanded, just like in the game
+        TILT_BOARD after = current;
+        uint8_t result = Tilt_Apply(&after, (TILT_DIRECTION)direction);
+        if (result & TILT_RESULT_LOSE)
+          next = TILT_GRAPH_LOSE;
+        else if (result & TILT_RESULT_WIN)
+          next = TILT_GRAPH_WIN;
+        else if (result & TILT_RESULT_MOVED) {
+          uint32_t child = FindOrInsert(solver, Tilt_PackKey(&after), &inserted);
+          if (inserted) {
+            if (tail >= limit || tail >= graph->capacity) {
+              solver->nodes[child].key = TILT_SOLVER_EMPTY_KEY;
+              status = TILT_SOLVE_OVERFLOW;
+              goto done;
+            }
+            solver->nodes[child].parent = tail;
+            solver->queue[tail++] = child;
+          }
+          next = solver->nodes[child].parent;
+        }
+      }
+      graph->next[state][direction] = next;
+    }
+  }
+
+ done:
+  graph->numStates = head;
+  for (uint32_t i = 0; i < tail; ++i)
+    solver->nodes[solver->queue[i]].key = TILT_SOLVER_EMPTY_KEY;
+  if (status != TILT_SOLVE_OK)
+    return status;
+
+  // Relax distances until nothing changes, the graphs are small and shallow enough that this is cheap
+  memset(graph->dist, TILT_GRAPH_UNSOLVABLE, graph->numStates);
+  if (!board->greens)
+    graph->dist[0] = 0;
+  bool changed;
+  do {
+    changed = false;
+    for (uint32_t state = graph->numStates; state > 0; --state) {
+      uint32_t i = state - 1;
+      uint8_t best = graph->dist[i];
+      for (uint8_t direction = 0; direction < TILT_NUM_DIRECTIONS; ++direction) {
+        uint32_t next = graph->next[i][direction];
+        uint8_t d = TILT_GRAPH_UNSOLVABLE;
+        if (next == TILT_GRAPH_WIN)
+          d = 1;
+        else if (next < graph->numStates && graph->dist[next] < TILT_GRAPH_UNSOLVABLE - 1)
+          d = graph->dist[next] + 1;
+        if (d < best)
+          best = d;
+      }
+      if (best != graph->dist[i]) {
+        graph->dist[i] = best;
+        changed = true;
+      }
+    }
+  } while (changed);
+
+  return status;
+}
+
+void TiltSolver_SolutionString(const TILT_SOLUTION* solution, char* str)
+{
+  for (uint8_t i = 0; i < solution->length; ++i)
+    str[i] = Tilt_DirectionChar((TILT_DIRECTION)solution->moves[i]);
+  str[solution->length] = '\0';
+}
+
+TILT_BAND TiltSolver_BandForLength(uint8_t length)
+{
+  if (length <= 12)
+    return TILT_BAND_BEGINNER;
+  else if (length <= 20)
+    return TILT_BAND_INTERMEDIATE;
+  else if (length <= 28)
+    return TILT_BAND_ADVANCED;
+  return TILT_BAND_EXPERT;
+}
+
+const char* TiltSolver_BandName(TILT_BAND band)
+{
+  static const char* names[TILT_NUM_BANDS] = { "BEGINNER", "INTERMEDIATE", "ADVANCED", "EXPERT" };
+  return names[band & 3];
+}
@@ -0,0 +1,128 @@
+/*
+
+  tiltsolver.h
+
+  Copyright 2026 Matthew T. Pandina. All rights reserved.
+
+  This file is part of Tilt Puzzle.
+
+  Tilt Puzzle is free software: you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation, either version 3 of the
+  License, or (at your option) any later version.
+
+  Tilt Puzzle is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Tilt Puzzle.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef TILTSOLVER_H
+#define TILTSOLVER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "tiltengine.h"
+
+// Breadth-first search for the shortest sequence of tilts that wins a board
+
+#define TILT_MAX_SOLUTION_LENGTH 64
+#define TILT_SOLVER_DEFAULT_LOG2_CAPACITY 20
+#define TILT_SOLVER_EMPTY_KEY UINT64_MAX
+
+// Return values of TiltSolver_Solve
+#define TILT_SOLVE_OK 0
+#define TILT_SOLVE_UNSOLVABLE 1
+#define TILT_SOLVE_OVERFLOW 2
+
+typedef struct {
+  uint64_t key; // Tilt_PackKey of the state, or TILT_SOLVER_EMPTY_KEY if the slot is free
+  uint32_t parent; // slot of the state this one was reached from
+  uint8_t move; // TILT_DIRECTION that was tilted to reach this state
+  uint8_t depth;
+} __attribute__ ((packed)) TILT_NODE;
+
+// Open-addressing transposition table plus the BFS queue, allocated once and reused for every solve
+typedef struct {
+  TILT_NODE* nodes;
+  uint32_t* queue;
+  uint32_t capacity;
+  uint32_t mask;
+  uint8_t log2Capacity;
+} TILT_SOLVER;
+
+typedef struct {
+  uint8_t length;
+  uint8_t moves[TILT_MAX_SOLUTION_LENGTH]; // TILT_DIRECTION of each tilt, in order
+  uint32_t states; // number of distinct states visited
+} TILT_SOLUTION;
+
+// Every state reachable from a board, with the outcome of each tilt, for analysis that needs the whole
+// picture rather than one optimal line. State 0 is the starting board.
+#define TILT_GRAPH_NONE UINT32_MAX          // the tilt moves nothing
+#define TILT_GRAPH_LOSE (UINT32_MAX - 1)    // the tilt drops a blue down the hole
+#define TILT_GRAPH_WIN (UINT32_MAX - 2)     // the tilt drops the last green down the hole
+#define TILT_GRAPH_UNSOLVABLE 0xFF
+
+typedef struct {
+  uint32_t capacity;
+  uint32_t numStates;
+  uint32_t (*next)[TILT_NUM_DIRECTIONS]; // next state for each TILT_DIRECTION, or a TILT_GRAPH_* code
+  uint8_t* dist;   // tilts needed to win from each state, or TILT_GRAPH_UNSOLVABLE
+  uint8_t* greens; // greens left in each state
+} TILT_GRAPH;
+
+// The difficulty bands of levels.h, in the order they are played
+typedef enum {
+  TILT_BAND_BEGINNER = 0,
+  TILT_BAND_INTERMEDIATE = 1,
+  TILT_BAND_ADVANCED = 2,
+  TILT_BAND_EXPERT = 3,
+} TILT_BAND;
+
+#define TILT_NUM_BANDS 4
+
+// Picks a band from the optimal solution length alone
+TILT_BAND TiltSolver_BandForLength(uint8_t length);
+
+const char* TiltSolver_BandName(TILT_BAND band);
+
+bool TiltSolver_Init(TILT_SOLVER* solver, uint8_t log2Capacity);
+void TiltSolver_Free(TILT_SOLVER* solver);
+
+/*
+ * TiltSolver_Solve
+ *
+ * Finds an optimal (fewest tilts) solution for a board
+ *
+ * solver [in]
+ *   A solver created with TiltSolver_Init. Each thread needs its own.
+ *
+ * board [in]
+ *   The starting board
+ *
+ * solution [out]
+ *   The moves of an optimal solution, and how many states were visited
+ *
+ * Returns:
+ *   TILT_SOLVE_OK if a solution was found, TILT_SOLVE_UNSOLVABLE if every
+ *   reachable state has been visited without winning, or TILT_SOLVE_OVERFLOW
+ *   if the transposition table filled up before the search finished.
+ */
+uint8_t TiltSolver_Solve(TILT_SOLVER* solver, const TILT_BOARD* board, TILT_SOLUTION* solution);
+
+bool TiltGraph_Init(TILT_GRAPH* graph, uint32_t capacity);
+void TiltGraph_Free(TILT_GRAPH* graph);
+
+// Explores every state reachable from board into graph, returns TILT_SOLVE_OK or TILT_SOLVE_OVERFLOW
+uint8_t TiltSolver_BuildGraph(TILT_SOLVER* solver, const TILT_BOARD* board, TILT_GRAPH* graph);
+
+// Writes the moves of a solution as a string of L/U/R/D characters
+void TiltSolver_SolutionString(const TILT_SOLUTION* solution, char* str);
+
+#endif // TILTSOLVER_H
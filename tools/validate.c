@@ -0,0 +1,221 @@
+/*
+
+  validate.c
+
+  Copyright 2026 Matthew T. Pandina. All rights reserved.
+
+  This file is part of Tilt Puzzle.
+
+  Tilt Puzzle is free software: you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation, either version 3 of the
+  License, or (at your option) any later version.
+
+  Tilt Puzzle is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Tilt Puzzle.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+// Checks a level pack (levels.h or anything in the same format) in a single streaming pass
+//
+// Usage: validate [-c cache] [pack]
+//
+// A level is rejected if it
+//   - uses a cell value other than 0, S, G, B, H or V
+//   - has something on the hole at the center of the board
+//   - has a gate next to the hole (the tileset has no art for it)
+//   - has more than MAX_MOVABLE_PIECES greens and blues (TiltBoard would lose moves)
+//   - has no greens, or cannot be solved
+//   - is a rotation or reflection of an earlier level
+//
+// Exits with 1 if any level was rejected, so it can gate the build. With -c, solve results are kept
+// in the given file (see tiltcache.h) and only new or edited levels are solved again.
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "tiltengine.h"
+#include "tiltsolver.h"
+#include "tiltpack.h"
+#include "tiltcache.h"
+
+#define SOLVER_LOG2_CAPACITY 18
+#define MIN_BYTES_PER_LEVEL (TILT_LEVEL_SIZE * 2) // "0," for every cell
+
+typedef struct {
+  uint64_t key;   // Tilt_CanonicalKey, or TILT_SOLVER_EMPTY_KEY
+  uint64_t gates; // the gates that go with it
+  uint32_t level;
+} SEEN;
+
+// Canonical keys of every level so far. It is sized once from the pack's file size, which bounds how many levels it can hold.
+typedef struct {
+  SEEN* entries;
+  uint64_t mask;
+  uint8_t log2Capacity;
+} SEEN_SET;
+
+static bool SeenSet_Init(SEEN_SET* set, uint64_t maxLevels)
+{
+  set->log2Capacity = 10;
+  while ((UINT64_C(1) << set->log2Capacity) < maxLevels + maxLevels / 2)
+    ++set->log2Capacity;
+  set->mask = (UINT64_C(1) << set->log2Capacity) - 1;
+  set->entries = malloc((set->mask + 1) * sizeof(SEEN));
+  if (!set->entries)
+    return false;
+  for (uint64_t i = 0; i <= set->mask; ++i)
+    set->entries[i].key = TILT_SOLVER_EMPTY_KEY;
+  return true;
+}
+
+// Returns the level that already had this key and these gates, or 0 after remembering them for level
+static uint32_t SeenSet_Insert(SEEN_SET* set, uint64_t key, uint64_t gates, uint32_t level)
+{
+  uint64_t slot = ((key ^ gates * UINT64_C(0xC2B2AE3D27D4EB4F)) * UINT64_C(0x9E3779B97F4A7C15)) >> (64 - set->log2Capacity);
+  for (;;) {
+    SEEN* entry = &set->entries[slot];
+    if (entry->key == key && entry->gates == gates)
+      return entry->level;
+    if (entry->key == TILT_SOLVER_EMPTY_KEY) {
+      entry->key = key;
+      entry->gates = gates;
+      entry->level = level;
+      return 0;
+    }
+    slot = (slot + 1) & set->mask;
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  const char* cachePath = NULL;
+  int opt;
+  while ((opt = getopt(argc, argv, "c:")) != -1) {
+    switch (opt) {
+    case 'c':
+      cachePath = optarg;
+      break;
+    default:
+      fprintf(stderr, "Usage: %s [-c cache] [pack]\n", argv[0]);
+      return -1;
+    }
+  }
+  const char* path = (optind < argc) ? argv[optind] : "../levels.h";
+
+  struct stat st;
+  TILT_PACK pack;
+  if (stat(path, &st) < 0 || !TiltPack_Open(&pack, path)) {
+    fprintf(stderr, "Error: Unable to open \"%s\"\n", path);
+    return -1;
+  }
+
+  Tilt_InitSymmetry();
+  TILT_SOLVER solver;
+  SEEN_SET seen;
+  if (!TiltSolver_Init(&solver, SOLVER_LOG2_CAPACITY) || !SeenSet_Init(&seen, st.st_size / MIN_BYTES_PER_LEVEL + 1)) {
+    fprintf(stderr, "Unable to allocate the transposition tables\n");
+    return -1;
+  }
+  TILT_CACHE cache;
+  if (cachePath && !TiltCache_Open(&cache, cachePath)) {
+    fprintf(stderr, "Unable to allocate the solution cache\n");
+    return -1;
+  }
+
+  uint32_t numLevels = 0;
+  uint32_t numRejected = 0;
+  uint8_t cells[TILT_LEVEL_SIZE];
+  uint32_t line;
+  uint8_t status;
+
+  while ((status = TiltPack_Next(&pack, cells, &line)) == TILT_PACK_OK) {
+    uint32_t level = ++numLevels;
+    bool rejected = false;
+
+#define REJECT(...) do {                                       \
+      printf("%s:%u: level %u: ", path, line, level);         \
+      printf(__VA_ARGS__);                                     \
+      printf("\n");                                            \
+      rejected = true;                                         \
+    } while (0)
+
+    for (uint8_t i = 0; i < TILT_LEVEL_SIZE; ++i)
+      if (cells[i] == TILT_CELL_INVALID)
+        REJECT("cell (%u,%u) is not 0, S, G, B, H or V", i % TILT_BOARD_WIDTH, i / TILT_BOARD_WIDTH);
+    if (rejected) {
+      ++numRejected;
+      continue;
+    }
+
+    TILT_BOARD board;
+    Tilt_FromCells(&board, cells);
+    uint8_t numMovable = Tilt_CountBits(board.greens | board.blues);
+
+    if ((board.stoppers | board.greens | board.blues | board.gatesH | board.gatesV) & TILT_MASK_HOLE)
+      REJECT("the hole at (%u,%u) is not empty", TILT_HOLE_X, TILT_HOLE_Y);
+    for (uint8_t i = 0; i < TILT_LEVEL_SIZE; ++i) {
+      uint8_t x = i % TILT_BOARD_WIDTH, y = i / TILT_BOARD_WIDTH;
+      if (((board.gatesH | board.gatesV) & (UINT32_C(1) << i)) && abs(x - TILT_HOLE_X) + abs(y - TILT_HOLE_Y) == 1)
+        REJECT("gate at (%u,%u) is next to the hole", x, y);
+    }
+    if (numMovable > TILT_MAX_MOVABLE_PIECES)
+      REJECT("%u greens and blues, but TiltBoard only tracks %u", numMovable, TILT_MAX_MOVABLE_PIECES);
+    if (!board.greens)
+      REJECT("no greens");
+
+    uint64_t gates;
+    uint64_t key = Tilt_CanonicalKey(&board, &gates);
+    uint32_t original = SeenSet_Insert(&seen, key, gates, level);
+    if (original)
+      REJECT("same as level %u under rotation or reflection", original);
+
+    // Only boards the game can represent are worth solving
+    if (!rejected) {
+      TILT_SOLUTION solution;
+      switch (cachePath ? TiltCache_Solve(&cache, &solver, &board, &solution) : TiltSolver_Solve(&solver, &board, &solution)) {
+      case TILT_SOLVE_OK:
+        break;
+      case TILT_SOLVE_UNSOLVABLE:
+        REJECT("cannot be solved (%u reachable states)", solution.states);
+        break;
+      default:
+        REJECT("too many states to solve");
+        break;
+      }
+    }
+
+#undef REJECT
+
+    if (rejected)
+      ++numRejected;
+  }
+
+  if (status == TILT_PACK_TRUNCATED) {
+    printf("%s:%u: the pack ends partway through level %u\n", path, pack.line, numLevels + 1);
+    ++numRejected;
+  }
+
+  printf("%s: %u level(s), %u rejected", path, numLevels, numRejected);
+  if (cachePath) {
+    printf(", %u solved, %u from %s", cache.misses, cache.hits, cachePath);
+    if (!TiltCache_Close(&cache))
+      fprintf(stderr, "\nError: Unable to write \"%s\"", cachePath);
+  }
+  printf("\n");
+
+  free(seen.entries);
+  TiltSolver_Free(&solver);
+  TiltPack_Close(&pack);
+  return numRejected ? 1 : 0;
+}